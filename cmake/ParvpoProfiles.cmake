@@ -0,0 +1,149 @@
+# Профили оптимизации для лабораторных.
+#
+# parvpo_add_profiles(<цель> [PGO_ARGS аргументы...] [RUN_ARGS аргументы...])
+#
+# Для уже объявленной исполняемой цели создает копии с теми же исходниками, библиотеками,
+# определениями и опциями, но со своими флагами:
+#   <цель>_O0 ... <цель>_Ofast, <цель>_Og, <цель>_Oz  - уровни оптимизации (Oz - если есть)
+#   <цель>_lto                                         - -O2 + LTO
+#   <цель>_native                                      - -O2 -march=native
+#   <цель>_pgo_gen -> <цель>_pgo_train -> <цель>_pgo   - PGO: сборка с инструментированием,
+#                                                        тренировочный запуск с PGO_ARGS,
+#                                                        сборка по профилю
+# Копии не входят в ALL: их собирает цель profiles, а цель matrix собирает и запускает все
+# с RUN_ARGS, складывая вывод и время в ${CMAKE_BINARY_DIR}/matrix.
+
+include(CheckCXXCompilerFlag)
+include(CheckIPOSupported)
+
+set(PARVPO_OPT_LEVELS O0 O1 O2 O3 Os Ofast Og)
+check_cxx_compiler_flag(-Oz PARVPO_HAS_OZ)
+if(PARVPO_HAS_OZ)
+    list(APPEND PARVPO_OPT_LEVELS Oz)
+endif()
+check_cxx_compiler_flag(-march=native PARVPO_HAS_MARCH_NATIVE)
+check_ipo_supported(RESULT PARVPO_HAS_IPO OUTPUT _parvpo_ipo_error LANGUAGES CXX)
+
+if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+    set(PARVPO_PGO_MODE gcc)
+elseif(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    get_filename_component(_parvpo_compiler_dir ${CMAKE_CXX_COMPILER} DIRECTORY)
+    string(REGEX MATCH "^[0-9]+" _parvpo_clang_major ${CMAKE_CXX_COMPILER_VERSION})
+    find_program(PARVPO_LLVM_PROFDATA NAMES llvm-profdata llvm-profdata-${_parvpo_clang_major}
+                 HINTS ${_parvpo_compiler_dir})
+    if(PARVPO_LLVM_PROFDATA)
+        set(PARVPO_PGO_MODE clang)
+    endif()
+endif()
+
+add_custom_target(profiles)
+set_property(GLOBAL PROPERTY PARVPO_MATRIX_ENTRIES "")
+
+function(_parvpo_profile_variant base variant flags link_flags)
+    get_target_property(sources ${base} SOURCES)
+    get_target_property(libs ${base} LINK_LIBRARIES)
+    get_target_property(defs ${base} COMPILE_DEFINITIONS)
+    get_target_property(opts ${base} COMPILE_OPTIONS)
+
+    set(target ${base}_${variant})
+    add_executable(${target} EXCLUDE_FROM_ALL ${sources})
+    if(libs)
+        target_link_libraries(${target} PRIVATE ${libs})
+    endif()
+    if(defs)
+        target_compile_definitions(${target} PRIVATE ${defs})
+    endif()
+    if(opts)
+        target_compile_options(${target} PRIVATE ${opts})
+    endif()
+    # Опции цели идут после CMAKE_CXX_FLAGS_<CONFIG>, поэтому -O профиля перекрывает -O конфигурации
+    target_compile_options(${target} PRIVATE ${flags})
+    target_link_options(${target} PRIVATE ${link_flags})
+endfunction()
+
+function(_parvpo_matrix_entry base variant run_args)
+    string(REPLACE ";" "\" \"" args "${run_args}")
+    if(args)
+        set(args "\"${args}\"")
+    endif()
+    set_property(GLOBAL APPEND PROPERTY PARVPO_MATRIX_ENTRIES
+        "{\"target\": \"${base}\", \"profile\": \"${variant}\", \"binary\": \"$<TARGET_FILE:${base}_${variant}>\", \"workdir\": \"${CMAKE_CURRENT_BINARY_DIR}\", \"args\": [${args}]}")
+    add_dependencies(profiles ${base}_${variant})
+endfunction()
+
+function(parvpo_add_profiles base)
+    cmake_parse_arguments(ARG "" "" "PGO_ARGS;RUN_ARGS" ${ARGN})
+
+    foreach(level IN LISTS PARVPO_OPT_LEVELS)
+        _parvpo_profile_variant(${base} ${level} "-${level}" "")
+        _parvpo_matrix_entry(${base} ${level} "${ARG_RUN_ARGS}")
+    endforeach()
+
+    if(PARVPO_HAS_IPO)
+        _parvpo_profile_variant(${base} lto "-O2" "")
+        set_property(TARGET ${base}_lto PROPERTY INTERPROCEDURAL_OPTIMIZATION TRUE)
+        _parvpo_matrix_entry(${base} lto "${ARG_RUN_ARGS}")
+    endif()
+
+    if(PARVPO_HAS_MARCH_NATIVE)
+        _parvpo_profile_variant(${base} native "-O2;-march=native" "")
+        _parvpo_matrix_entry(${base} native "${ARG_RUN_ARGS}")
+    endif()
+
+    if(NOT PARVPO_PGO_MODE)
+        return()
+    endif()
+    set(gen_dir ${CMAKE_CURRENT_BINARY_DIR}/CMakeFiles/${base}_pgo_gen.dir)
+    set(use_dir ${CMAKE_CURRENT_BINARY_DIR}/CMakeFiles/${base}_pgo.dir)
+    if(PARVPO_PGO_MODE STREQUAL "gcc")
+        # .gcda пишется рядом с объектным файлом; тренировка копирует его в каталог объектов _pgo
+        _parvpo_profile_variant(${base} pgo_gen "-O2;-fprofile-generate;-fprofile-update=prefer-atomic" "-fprofile-generate")
+        _parvpo_profile_variant(${base} pgo "-O2;-fprofile-use;-fprofile-correction;-Wno-missing-profile" "-fprofile-use")
+    else()
+        set(profdata ${CMAKE_CURRENT_BINARY_DIR}/${base}.profdata)
+        _parvpo_profile_variant(${base} pgo_gen "-O2;-fprofile-instr-generate" "-fprofile-instr-generate")
+        _parvpo_profile_variant(${base} pgo "-O2;-fprofile-instr-use=${profdata}" "")
+    endif()
+
+    # Тренировка перезапускается только при пересборке инструментированного бинарника
+    string(REPLACE ";" "|" pgo_args "${ARG_PGO_ARGS}")
+    set(stamp ${CMAKE_CURRENT_BINARY_DIR}/${base}.pgo_stamp)
+    add_custom_command(OUTPUT ${stamp}
+        COMMAND ${CMAKE_COMMAND}
+                -DMODE=${PARVPO_PGO_MODE}
+                -DEXE=$<TARGET_FILE:${base}_pgo_gen>
+                -DARGS=${pgo_args}
+                -DWORKDIR=${CMAKE_CURRENT_BINARY_DIR}
+                -DGEN_DIR=${gen_dir}
+                -DUSE_DIR=${use_dir}
+                -DPROFDATA=${profdata}
+                -DLLVM_PROFDATA=${PARVPO_LLVM_PROFDATA}
+                -P ${PARVPO_CMAKE_DIR}/pgo_train.cmake
+        COMMAND ${CMAKE_COMMAND} -E touch ${stamp}
+        DEPENDS ${base}_pgo_gen ${PARVPO_CMAKE_DIR}/pgo_train.cmake
+        COMMENT "PGO: тренировочный запуск ${base}"
+        VERBATIM)
+    add_custom_target(${base}_pgo_train DEPENDS ${stamp})
+    add_dependencies(${base}_pgo ${base}_pgo_train)
+    _parvpo_matrix_entry(${base} pgo "${ARG_RUN_ARGS}")
+endfunction()
+
+# Цель matrix: собирает все профили и запускает их (cmake/run_matrix.py).
+# Вызывается один раз в конце корневого CMakeLists.txt.
+function(parvpo_add_matrix_target)
+    find_package(Python3 COMPONENTS Interpreter)
+    get_property(entries GLOBAL PROPERTY PARVPO_MATRIX_ENTRIES)
+    string(REPLACE ";" ",\n  " entries "${entries}")
+    set(manifest ${CMAKE_BINARY_DIR}/matrix_manifest.json)
+    file(GENERATE OUTPUT ${manifest} CONTENT "[\n  ${entries}\n]\n")
+    if(NOT Python3_Interpreter_FOUND)
+        message(STATUS "Python 3 не найден: цель matrix недоступна")
+        return()
+    endif()
+    add_custom_target(matrix
+        COMMAND ${Python3_EXECUTABLE} ${PARVPO_CMAKE_DIR}/run_matrix.py ${manifest} ${CMAKE_BINARY_DIR}/matrix
+        COMMENT "Запуск всех профилей оптимизации"
+        USES_TERMINAL
+        VERBATIM)
+    add_dependencies(matrix profiles)
+endfunction()
@@ -0,0 +1,55 @@
+# Тренировочный запуск для PGO (вызывается из parvpo_add_profiles через cmake -P).
+#   MODE       gcc | clang
+#   EXE        инструментированный бинарник, ARGS - его аргументы через "|"
+#   WORKDIR    рабочий каталог запуска
+#   GEN_DIR    каталог объектов инструментированной цели (gcc: там появляются .gcda)
+#   USE_DIR    каталог объектов цели, собираемой по профилю
+#   PROFDATA   итоговый профиль clang, LLVM_PROFDATA - путь к llvm-profdata
+
+string(REPLACE "|" ";" args "${ARGS}")
+
+if(MODE STREQUAL "gcc")
+    file(GLOB_RECURSE stale "${GEN_DIR}/*.gcda")
+    if(stale)
+        file(REMOVE ${stale})
+    endif()
+else()
+    set(raw_dir "${WORKDIR}/pgo_raw")
+    file(REMOVE_RECURSE "${raw_dir}")
+    file(MAKE_DIRECTORY "${raw_dir}")
+    set(ENV{LLVM_PROFILE_FILE} "${raw_dir}/%p.profraw")
+endif()
+
+execute_process(COMMAND "${EXE}" ${args}
+                WORKING_DIRECTORY "${WORKDIR}"
+                RESULT_VARIABLE result
+                OUTPUT_QUIET)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "PGO: тренировочный запуск ${EXE} завершился с кодом ${result}")
+endif()
+
+if(MODE STREQUAL "gcc")
+    # Профиль объекта X.o лежит в X.gcda; переносим с тем же относительным путем
+    file(GLOB_RECURSE profiles RELATIVE "${GEN_DIR}" "${GEN_DIR}/*.gcda")
+    if(NOT profiles)
+        message(FATAL_ERROR "PGO: после запуска ${EXE} не найдено ни одного .gcda в ${GEN_DIR}")
+    endif()
+    foreach(profile IN LISTS profiles)
+        get_filename_component(dir "${USE_DIR}/${profile}" DIRECTORY)
+        file(MAKE_DIRECTORY "${dir}")
+        execute_process(COMMAND "${CMAKE_COMMAND}" -E copy "${GEN_DIR}/${profile}" "${USE_DIR}/${profile}")
+    endforeach()
+else()
+    file(GLOB raw "${raw_dir}/*.profraw")
+    execute_process(COMMAND "${LLVM_PROFDATA}" merge -output=${PROFDATA} ${raw}
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "PGO: llvm-profdata merge завершился с кодом ${result}")
+    endif()
+endif()
+
+# Объекты, собранные по старому профилю, удаляются, чтобы цель пересобралась по новому
+file(GLOB_RECURSE objects "${USE_DIR}/*.o")
+if(objects)
+    file(REMOVE ${objects})
+endif()
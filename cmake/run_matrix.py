@@ -0,0 +1,60 @@
+"""Запуск всех профилей оптимизации (цель matrix).
+
+Использование: run_matrix.py <matrix_manifest.json> <каталог результатов>
+
+Для каждого бинарника из манифеста сохраняет вывод в <каталог>/<цель>_<профиль>.txt,
+JSON аппаратных счетчиков (common/perf_counters.h) в <каталог>/<цель>_<профиль>.perf.json
+и сводку в <каталог>/matrix.csv: время работы и размер бинарника.
+"""
+import csv
+import json
+import os
+import subprocess
+import sys
+import time
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__)
+        return 1
+    with open(sys.argv[1], encoding='utf-8') as f:
+        entries = json.load(f)
+    out_dir = sys.argv[2]
+    os.makedirs(out_dir, exist_ok=True)
+
+    rows = []
+    failed = 0
+    for entry in entries:
+        name = f"{entry['target']}_{entry['profile']}"
+        print(f'Запускаю {name}...', flush=True)
+        env = dict(os.environ, PERF_JSON=os.path.join(out_dir, f'{name}.perf.json'))
+        start = time.perf_counter()
+        run = subprocess.run([entry['binary']] + entry['args'], cwd=entry['workdir'], env=env,
+                             capture_output=True)
+        run_time = time.perf_counter() - start
+        with open(os.path.join(out_dir, f'{name}.txt'), 'wb') as f:
+            f.write(run.stdout)
+            f.write(run.stderr)
+        if run.returncode != 0:
+            print(f'  ошибка: код возврата {run.returncode}')
+            failed += 1
+        rows.append({
+            'target': entry['target'],
+            'profile': entry['profile'],
+            'run_time': run_time,
+            'file_size': os.path.getsize(entry['binary']) / 1024,  # КБ
+            'returncode': run.returncode,
+        })
+
+    csv_file = os.path.join(out_dir, 'matrix.csv')
+    with open(csv_file, 'w', newline='', encoding='utf-8') as f:
+        writer = csv.DictWriter(f, fieldnames=['target', 'profile', 'run_time', 'file_size', 'returncode'])
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f'Результаты сохранены в {csv_file}')
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,348 @@
+#ifndef ASYNC_READER_H
+#define ASYNC_READER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "thread_pool.h"
+
+// Только Linux: O_DIRECT, pread и io_uring; на других системах заголовок пуст
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>)
+  #include <linux/io_uring.h>
+  #define ASYNC_READER_URING 1
+  // linux/fs.h (через io_uring.h) определяет макросы с общими именами
+  #undef BLOCK_SIZE
+  #undef BLOCK_SIZE_BITS
+#endif
+
+// Асинхронное случайное чтение блоков файла с заданной глубиной очереди (QD):
+//   uring - io_uring через системные вызовы (без liburing): в кольце держится до QD чтений;
+//   pool  - пул из QD потоков, каждый делает синхронный pread (запасной вариант,
+//           если ядро или seccomp не дают io_uring).
+// O_DIRECT читает мимо page cache: блок, смещения и буферы выровнены на 4096.
+// Зарегистрированные буферы (только uring) избавляют ядро от отображения страниц на каждое чтение.
+// Для каждого чтения запоминается задержка от постановки в очередь до завершения.
+
+constexpr size_t ASYNC_ALIGN = 4096;
+
+enum class AsyncEngine { AUTO, URING, POOL };
+
+inline const char* async_engine_name(AsyncEngine engine) {
+    switch (engine) {
+        case AsyncEngine::AUTO:  return "auto";
+        case AsyncEngine::URING: return "uring";
+        case AsyncEngine::POOL:  return "pool";
+    }
+    return "unknown";
+}
+
+inline std::optional<AsyncEngine> parse_async_engine(const std::string& name) {
+    for (AsyncEngine engine : {AsyncEngine::AUTO, AsyncEngine::URING, AsyncEngine::POOL}) {
+        if (name == async_engine_name(engine)) return engine;
+    }
+    return std::nullopt;
+}
+
+struct AsyncReadOptions {
+    size_t queue_depth = 1;
+    size_t block = ASYNC_ALIGN;
+    bool direct = false;
+    bool registered = false;
+};
+
+struct AsyncReadResult {
+    AsyncEngine engine = AsyncEngine::AUTO;  // чем на самом деле читали
+    double seconds = 0.0;
+    std::vector<double> latencies_ns;        // по одному на чтение, в порядке offsets
+    uint64_t checksum = 0;                   // сумма всех прочитанных байт
+
+    double iops() const { return latencies_ns.size() / seconds; }
+
+    // Процентиль задержки, мкс (q от 0 до 1)
+    double latency_us(double q) const {
+        if (latencies_ns.empty()) return 0.0;
+        std::vector<double> sorted = latencies_ns;
+        size_t k = std::min(sorted.size() - 1, static_cast<size_t>(q * (sorted.size() - 1) + 0.5));
+        std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+        return sorted[k] / 1e3;
+    }
+};
+
+namespace async_detail {
+
+using Clock = std::chrono::steady_clock;
+
+struct FreeDeleter {
+    void operator()(char* p) const { std::free(p); }
+};
+
+// QD буферов по block байт подряд, выровненных для O_DIRECT
+inline std::unique_ptr<char, FreeDeleter> aligned_buffers(const AsyncReadOptions& opts) {
+    size_t bytes = (opts.block * opts.queue_depth + ASYNC_ALIGN - 1) / ASYNC_ALIGN * ASYNC_ALIGN;
+    char* p = static_cast<char*>(std::aligned_alloc(ASYNC_ALIGN, bytes));
+    if (p == nullptr) throw std::bad_alloc();
+    return std::unique_ptr<char, FreeDeleter>(p);
+}
+
+inline int open_for_reads(const std::string& path, bool direct) {
+    int fd = ::open(path.c_str(), O_RDONLY | (direct ? O_DIRECT : 0));
+    if (fd < 0) throw std::runtime_error("open(" + path + "): " + std::strerror(errno));
+    return fd;
+}
+
+inline uint64_t byte_sum(const char* p, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += static_cast<unsigned char>(p[i]);
+    return sum;
+}
+
+inline double elapsed_ns(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::nano>(to - from).count();
+}
+
+}  // namespace async_detail
+
+// Синхронный pread в QD потоках: каждый поток берет следующее смещение и читает в свой буфер
+class PreadPoolEngine {
+public:
+    PreadPoolEngine(const std::string& path, const AsyncReadOptions& opts)
+        : opts(opts), fd(async_detail::open_for_reads(path, opts.direct)),
+          buffers(async_detail::aligned_buffers(opts)), pool(static_cast<unsigned>(opts.queue_depth)) {}
+
+    PreadPoolEngine(const PreadPoolEngine&) = delete;
+    PreadPoolEngine& operator=(const PreadPoolEngine&) = delete;
+    ~PreadPoolEngine() { ::close(fd); }
+
+    AsyncReadResult run(const std::vector<uint64_t>& offsets) {
+        AsyncReadResult result;
+        result.engine = AsyncEngine::POOL;
+        result.latencies_ns.resize(offsets.size());
+        std::vector<uint64_t> sums(pool.size(), 0);
+        std::atomic<bool> failed{false};
+        auto begin = async_detail::Clock::now();
+        pool.parallel_for_worker(offsets.size(), [&](size_t i, unsigned worker) {
+            char* buf = buffers.get() + worker * opts.block;
+            auto start = async_detail::Clock::now();
+            ssize_t got = ::pread(fd, buf, opts.block, static_cast<off_t>(offsets[i]));
+            result.latencies_ns[i] = async_detail::elapsed_ns(start, async_detail::Clock::now());
+            if (got < 0) {
+                failed = true;
+                return;
+            }
+            sums[worker] += async_detail::byte_sum(buf, static_cast<size_t>(got));
+        });
+        result.seconds = std::chrono::duration<double>(async_detail::Clock::now() - begin).count();
+        if (failed) throw std::runtime_error("pread: ошибка чтения");
+        for (uint64_t s : sums) result.checksum += s;
+        return result;
+    }
+
+private:
+    AsyncReadOptions opts;
+    int fd;
+    std::unique_ptr<char, async_detail::FreeDeleter> buffers;
+    ThreadPool pool;
+};
+
+#ifdef ASYNC_READER_URING
+
+// Кольцо io_uring на QD записей: очередь пополняется, как только приходит завершение
+class IoUringEngine {
+public:
+    IoUringEngine(const std::string& path, const AsyncReadOptions& opts)
+        : opts(opts), buffers(async_detail::aligned_buffers(opts)) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, static_cast<unsigned>(opts.queue_depth), &params));
+        if (ring_fd < 0) fail("io_uring_setup");
+        try {
+            map_rings(params);
+            file_fd = async_detail::open_for_reads(path, opts.direct);
+            if (opts.registered) register_buffers();
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    IoUringEngine(const IoUringEngine&) = delete;
+    IoUringEngine& operator=(const IoUringEngine&) = delete;
+    ~IoUringEngine() { release(); }
+
+    AsyncReadResult run(const std::vector<uint64_t>& offsets) {
+        AsyncReadResult result;
+        result.engine = AsyncEngine::URING;
+        result.latencies_ns.resize(offsets.size());
+        std::vector<size_t> slot_request(opts.queue_depth);
+        std::vector<async_detail::Clock::time_point> slot_start(opts.queue_depth);
+        std::vector<unsigned> free_slots;
+        for (size_t s = opts.queue_depth; s-- > 0;) free_slots.push_back(static_cast<unsigned>(s));
+
+        size_t next = 0, done = 0;
+        auto begin = async_detail::Clock::now();
+        while (done < offsets.size()) {
+            unsigned queued = 0;
+            while (next < offsets.size() && !free_slots.empty()) {
+                unsigned slot = free_slots.back();
+                free_slots.pop_back();
+                slot_request[slot] = next;
+                slot_start[slot] = async_detail::Clock::now();
+                push_read(slot, offsets[next++]);
+                ++queued;
+            }
+            if (::syscall(__NR_io_uring_enter, ring_fd, queued, 1u, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                errno != EINTR) {
+                fail("io_uring_enter");
+            }
+            unsigned head = *cq_head;
+            unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes[head & *cq_mask];
+                unsigned slot = static_cast<unsigned>(cqe.user_data);
+                if (cqe.res < 0) {
+                    errno = -cqe.res;
+                    fail("io_uring read");
+                }
+                result.latencies_ns[slot_request[slot]] =
+                    async_detail::elapsed_ns(slot_start[slot], async_detail::Clock::now());
+                result.checksum += async_detail::byte_sum(buffers.get() + slot * opts.block, cqe.res);
+                free_slots.push_back(slot);
+                ++done;
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+        result.seconds = std::chrono::duration<double>(async_detail::Clock::now() - begin).count();
+        return result;
+    }
+
+private:
+    void map_rings(const io_uring_params& params) {
+        sq_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sq_bytes = cq_bytes = std::max(sq_bytes, cq_bytes);
+        sq_ring = map(sq_bytes, IORING_OFF_SQ_RING);
+        cq_ring = single ? sq_ring : map(cq_bytes, IORING_OFF_CQ_RING);
+        sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(map(sqes_bytes, IORING_OFF_SQES));
+
+        char* sq = static_cast<char*>(sq_ring);
+        char* cq = static_cast<char*>(cq_ring);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void* map(size_t bytes, off_t offset) {
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+        if (p == MAP_FAILED) fail("mmap io_uring");
+        return p;
+    }
+
+    void register_buffers() {
+        std::vector<iovec> iov(opts.queue_depth);
+        for (size_t s = 0; s < iov.size(); ++s) iov[s] = {buffers.get() + s * opts.block, opts.block};
+        if (::syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS, iov.data(),
+                      static_cast<unsigned>(iov.size())) < 0) {
+            fail("io_uring_register");
+        }
+    }
+
+    void push_read(unsigned slot, uint64_t offset) {
+        unsigned tail = *sq_tail;
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opts.registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe.fd = file_fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buffers.get() + slot * opts.block);
+        sqe.len = static_cast<unsigned>(opts.block);
+        sqe.off = offset;
+        sqe.buf_index = static_cast<uint16_t>(slot);
+        sqe.user_data = slot;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    void release() {
+        if (sqes != nullptr) ::munmap(sqes, sqes_bytes);
+        if (cq_ring != nullptr && cq_ring != sq_ring) ::munmap(cq_ring, cq_bytes);
+        if (sq_ring != nullptr) ::munmap(sq_ring, sq_bytes);
+        if (file_fd >= 0) ::close(file_fd);
+        if (ring_fd >= 0) ::close(ring_fd);
+        sqes = nullptr;
+        sq_ring = cq_ring = nullptr;
+        file_fd = ring_fd = -1;
+    }
+
+    [[noreturn]] static void fail(const char* what) {
+        throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+    }
+
+    AsyncReadOptions opts;
+    std::unique_ptr<char, async_detail::FreeDeleter> buffers;
+    int ring_fd = -1;
+    int file_fd = -1;
+    void* sq_ring = nullptr;
+    void* cq_ring = nullptr;
+    size_t sq_bytes = 0, cq_bytes = 0, sqes_bytes = 0;
+    io_uring_sqe* sqes = nullptr;
+    unsigned *sq_tail = nullptr, *sq_mask = nullptr, *sq_array = nullptr;
+    unsigned *cq_head = nullptr, *cq_tail = nullptr, *cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+};
+
+#endif
+
+// Читает блоки по offsets выбранным движком. AUTO пробует io_uring и при ошибке
+// настройки кольца переходит на пул pread; какой движок сработал - в result.engine.
+// Зарегистрированные буферы есть только у io_uring, поэтому с opts.registered AUTO
+// ведет себя как URING: ошибка регистрации (например, RLIMIT_MEMLOCK) пробрасывается,
+// а не превращается молча в замер пула без них.
+// Ошибки самих чтений не маскируются переходом на пул, а пробрасываются.
+inline AsyncReadResult run_async_reads(AsyncEngine engine, const std::string& path,
+                                       const std::vector<uint64_t>& offsets, const AsyncReadOptions& opts) {
+    if (opts.registered && engine == AsyncEngine::POOL) {
+        throw std::runtime_error("зарегистрированные буферы есть только у io_uring");
+    }
+#ifdef ASYNC_READER_URING
+    if (engine != AsyncEngine::POOL) {
+        std::optional<IoUringEngine> uring;
+        try {
+            uring.emplace(path, opts);
+        } catch (const std::runtime_error&) {
+            if (engine == AsyncEngine::URING || opts.registered) throw;
+        }
+        if (uring) return uring->run(offsets);
+    }
+#else
+    if (engine == AsyncEngine::URING || opts.registered) throw std::runtime_error("io_uring недоступен при сборке");
+#endif
+    PreadPoolEngine pool(path, opts);
+    return pool.run(offsets);
+}
+
+#endif  // __linux__
+
+#endif
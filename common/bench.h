@@ -0,0 +1,272 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "first_touch.h"
+#include "perf_counters.h"
+
+// Общий микробенчмарк для лабораторных: ядро регистрируется по имени, прогревается,
+// затем повторяется, пока не наберется min_seconds (но не меньше min_repetitions и не больше
+// max_repetitions раз). По выборке времен считаются min/median/p95/mean/stddev; рядом -
+// средние по повторению значения аппаратных счетчиков, если они доступны.
+// Вывод - таблица, JSON или CSV; таблица идет в stdout, JSON/CSV - в stdout или в файл --out.
+//
+// Опции командной строки (parse_bench_options):
+//   --warmup=N  --reps=MIN[:MAX]  --min-time=SECONDS  --pin=CPU
+//   --format=table|json|csv  --out=PATH  --filter=ПОДСТРОКА  --no-counters
+
+// Значение считается использованным: компилятор не может выбросить его вычисление
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    volatile const T* sink = &value;
+    (void)sink;
+#endif
+}
+
+// Все записи в память считаются видимыми, а память - прочитанной
+inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+enum class BenchFormat { TABLE, JSON, CSV };
+
+struct BenchOptions {
+    size_t warmup = 1;
+    size_t min_repetitions = 5;
+    size_t max_repetitions = 1000;
+    double min_seconds = 0.5;
+    int pin_cpu = -1;
+    BenchFormat format = BenchFormat::TABLE;
+    std::string output;
+    std::string filter;
+    bool counters = true;
+};
+
+struct BenchStats {
+    size_t repetitions = 0;
+    double min = 0, median = 0, p95 = 0, mean = 0, stddev = 0;
+
+    static BenchStats from_samples(std::vector<double> samples) {
+        BenchStats s;
+        s.repetitions = samples.size();
+        if (samples.empty()) return s;
+        std::sort(samples.begin(), samples.end());
+        size_t n = samples.size();
+        s.min = samples.front();
+        s.median = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+        s.p95 = samples[std::min(n - 1, static_cast<size_t>(std::ceil(0.95 * n)) - 1)];
+        double sum = 0;
+        for (double x : samples) sum += x;
+        s.mean = sum / n;
+        double sq = 0;
+        for (double x : samples) sq += (x - s.mean) * (x - s.mean);
+        s.stddev = n > 1 ? std::sqrt(sq / (n - 1)) : 0.0;
+        return s;
+    }
+};
+
+struct BenchResult {
+    std::string name;
+    BenchStats stats;  // секунды на одно повторение
+    std::vector<std::pair<PerfEvent, double>> counters;  // среднее на повторение
+    unsigned threads = 1;  // потоков в ядре; счетчики только по вызывающему (см. perf_counters.h)
+};
+
+// Разбор опций начиная с argv[first]; неизвестный аргумент - std::invalid_argument
+inline BenchOptions parse_bench_options(int argc, char* argv[], int first = 1) {
+    BenchOptions opts;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const char* key) -> const char* {
+            size_t len = std::char_traits<char>::length(key);
+            return arg.compare(0, len, key) == 0 ? arg.c_str() + len : nullptr;
+        };
+        if (const char* v = value("--warmup=")) {
+            opts.warmup = std::strtoull(v, nullptr, 10);
+        } else if (const char* v = value("--reps=")) {
+            char* rest = nullptr;
+            opts.min_repetitions = std::max<size_t>(1, std::strtoull(v, &rest, 10));
+            opts.max_repetitions = *rest == ':' ? std::strtoull(rest + 1, nullptr, 10) : opts.min_repetitions;
+            opts.max_repetitions = std::max(opts.max_repetitions, opts.min_repetitions);
+            if (*rest != ':') opts.min_seconds = 0.0;
+        } else if (const char* v = value("--min-time=")) {
+            opts.min_seconds = std::atof(v);
+        } else if (const char* v = value("--pin=")) {
+            opts.pin_cpu = std::atoi(v);
+        } else if (const char* v = value("--format=")) {
+            std::string f = v;
+            if (f == "table") opts.format = BenchFormat::TABLE;
+            else if (f == "json") opts.format = BenchFormat::JSON;
+            else if (f == "csv") opts.format = BenchFormat::CSV;
+            else throw std::invalid_argument("unknown bench format: " + f);
+        } else if (const char* v = value("--out=")) {
+            opts.output = v;
+        } else if (const char* v = value("--filter=")) {
+            opts.filter = v;
+        } else if (arg == "--no-counters") {
+            opts.counters = false;
+        } else {
+            throw std::invalid_argument("unknown bench option: " + arg);
+        }
+    }
+    return opts;
+}
+
+inline std::string bench_to_json(const std::vector<BenchResult>& results) {
+    std::ostringstream out;
+    out.precision(9);
+    out << "{\"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << (i ? ",\n  " : "\n  ") << "{\"name\": \"" << PerfSample::json_escape(r.name) << "\""
+            << ", \"repetitions\": " << r.stats.repetitions << ", \"min\": " << r.stats.min
+            << ", \"median\": " << r.stats.median << ", \"p95\": " << r.stats.p95
+            << ", \"mean\": " << r.stats.mean << ", \"stddev\": " << r.stats.stddev << ", \"counters\": {";
+        for (size_t k = 0; k < r.counters.size(); ++k) {
+            out << (k ? ", " : "") << "\"" << perf_event_name(r.counters[k].first) << "\": " << r.counters[k].second;
+        }
+        out << "}";
+        if (r.threads > 1) out << ", \"threads\": " << r.threads << ", \"counters_scope\": \"calling_thread\"";
+        out << "}";
+    }
+    out << (results.empty() ? "]}\n" : "\n]}\n");
+    return out.str();
+}
+
+inline std::string bench_to_csv(const std::vector<BenchResult>& results) {
+    std::ostringstream out;
+    out.precision(9);
+    out << "name,repetitions,min,median,p95,mean,stddev";
+    for (PerfEvent e : ALL_PERF_EVENTS) out << "," << perf_event_name(e);
+    out << ",threads\n";
+    for (const BenchResult& r : results) {
+        out << "\"" << r.name << "\"," << r.stats.repetitions << "," << r.stats.min << "," << r.stats.median
+            << "," << r.stats.p95 << "," << r.stats.mean << "," << r.stats.stddev;
+        for (PerfEvent e : ALL_PERF_EVENTS) {
+            out << ",";
+            for (const auto& [event, value] : r.counters) {
+                if (event == e) out << value;
+            }
+        }
+        out << "," << r.threads << "\n";
+    }
+    return out.str();
+}
+
+inline std::string bench_to_table(const std::vector<BenchResult>& results) {
+    std::ostringstream out;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-48s %6s %12s %12s %12s %12s\n", "benchmark", "reps", "min, ms",
+                  "median, ms", "p95, ms", "stddev, ms");
+    out << line;
+    for (const BenchResult& r : results) {
+        std::snprintf(line, sizeof(line), "%-48s %6zu %12.4f %12.4f %12.4f %12.4f\n", r.name.c_str(),
+                      r.stats.repetitions, r.stats.min * 1e3, r.stats.median * 1e3, r.stats.p95 * 1e3,
+                      r.stats.stddev * 1e3);
+        out << line;
+    }
+    return out.str();
+}
+
+class BenchRegistry {
+public:
+    // threads - сколько потоков работает в ядре (пул, OpenMP); счетчики считают только вызывающий
+    void add(std::string name, std::function<void()> kernel, unsigned threads = 1) {
+        benchmarks.push_back({std::move(name), std::move(kernel), threads});
+    }
+
+    BenchResult run_one(const std::string& name, const std::function<void()>& kernel, const BenchOptions& opts,
+                        unsigned threads = 1) const {
+        for (size_t i = 0; i < opts.warmup; ++i) {
+            kernel();
+            clobber_memory();
+        }
+        std::vector<double> samples;
+        std::vector<std::pair<PerfEvent, double>> totals;
+        PerfCounters counters(opts.counters ? ALL_PERF_EVENTS : std::initializer_list<PerfEvent>{});
+        double elapsed = 0.0;
+        while (samples.size() < opts.max_repetitions &&
+               (samples.size() < opts.min_repetitions || elapsed < opts.min_seconds)) {
+            counters.start();
+            auto start = std::chrono::steady_clock::now();
+            kernel();
+            clobber_memory();
+            auto end = std::chrono::steady_clock::now();
+            counters.stop();
+            double t = std::chrono::duration<double>(end - start).count();
+            samples.push_back(t);
+            elapsed += t;
+            auto values = counters.values();
+            if (totals.empty()) {
+                for (const auto& [event, value] : values) totals.emplace_back(event, 0.0);
+            }
+            for (size_t k = 0; k < values.size(); ++k) totals[k].second += values[k].second;
+        }
+        for (auto& total : totals) total.second /= samples.size();
+        return {name, BenchStats::from_samples(std::move(samples)), std::move(totals), threads};
+    }
+
+    // Прогоняет все ядра, имя которых содержит opts.filter; код возврата для main
+    int run(const BenchOptions& opts) const {
+        if (opts.pin_cpu >= 0 && !pin_current_thread(opts.pin_cpu)) {
+            std::cerr << "bench: не удалось закрепить поток за CPU " << opts.pin_cpu << std::endl;
+        }
+        std::vector<BenchResult> results;
+        for (const auto& [name, kernel, threads] : benchmarks) {
+            if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos) continue;
+            results.push_back(run_one(name, kernel, opts, threads));
+        }
+        std::string text = opts.format == BenchFormat::JSON  ? bench_to_json(results)
+                         : opts.format == BenchFormat::CSV   ? bench_to_csv(results)
+                                                             : bench_to_table(results);
+        if (opts.output.empty()) {
+            std::cout << text;
+        } else {
+            std::ofstream out(opts.output);
+            if (!out) {
+                std::cerr << "bench: не удалось открыть " << opts.output << std::endl;
+                return 1;
+            }
+            out << text;
+        }
+        return 0;
+    }
+
+    // Точка входа для режима "main.exe bench [опции]": опции начинаются с argv[first]
+    int main(int argc, char* argv[], int first = 2) const {
+        try {
+            return run(parse_bench_options(argc, argv, first));
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "bench: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        std::function<void()> kernel;
+        unsigned threads;
+    };
+    std::vector<Entry> benchmarks;
+};
+
+#endif
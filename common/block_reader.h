@@ -0,0 +1,143 @@
+#ifndef BLOCK_READER_H
+#define BLOCK_READER_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#ifdef __linux__
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #include "mapped_file.h"
+#endif
+
+// Источники случайного чтения блоков файла для lab2/lab3:
+//   ifstream - seekg + read через общий поток (исходный вариант; в основном измеряет iostream);
+//   pread    - системный вызов на каждое чтение, без буфера потока и без позиции файла;
+//   mmap     - файл отображен в память, чтение - обычная загрузка по указателю.
+// Все источники читают одни и те же байты, поэтому контрольные суммы совпадают.
+// pread и mmap есть только под Linux.
+
+enum class ReadBackend { IFSTREAM, PREAD, MMAP };
+
+inline const char* read_backend_name(ReadBackend backend) {
+    switch (backend) {
+        case ReadBackend::IFSTREAM: return "ifstream";
+        case ReadBackend::PREAD:    return "pread";
+        case ReadBackend::MMAP:     return "mmap";
+    }
+    return "unknown";
+}
+
+inline std::vector<ReadBackend> available_read_backends() {
+#ifdef __linux__
+    return {ReadBackend::IFSTREAM, ReadBackend::PREAD, ReadBackend::MMAP};
+#else
+    return {ReadBackend::IFSTREAM};
+#endif
+}
+
+inline std::optional<ReadBackend> parse_read_backend(const std::string& name) {
+    for (ReadBackend backend : available_read_backends()) {
+        if (name == read_backend_name(backend)) return backend;
+    }
+    return std::nullopt;
+}
+
+class IfstreamBlockReader {
+public:
+    explicit IfstreamBlockReader(const std::string& path) : file(path, std::ios::binary) {
+        if (!file) throw std::runtime_error("ifstream(" + path + "): не удалось открыть");
+    }
+
+    void read(size_t offset, char* out, size_t n) {
+        file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+        file.read(out, static_cast<std::streamsize>(n));
+    }
+
+private:
+    std::ifstream file;
+};
+
+#ifdef __linux__
+
+class PreadBlockReader {
+public:
+    explicit PreadBlockReader(const std::string& path) : fd(::open(path.c_str(), O_RDONLY)) {
+        if (fd < 0) throw std::runtime_error("open(" + path + "): " + std::strerror(errno));
+    }
+
+    PreadBlockReader(PreadBlockReader&& other) noexcept : fd(std::exchange(other.fd, -1)) {}
+    PreadBlockReader& operator=(PreadBlockReader&& other) noexcept {
+        std::swap(fd, other.fd);
+        return *this;
+    }
+    PreadBlockReader(const PreadBlockReader&) = delete;
+    PreadBlockReader& operator=(const PreadBlockReader&) = delete;
+    ~PreadBlockReader() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    // Короткое чтение (конец файла) оставляет хвост out нетронутым, как и ifstream
+    void read(size_t offset, char* out, size_t n) {
+        while (n > 0) {
+            ssize_t got = ::pread(fd, out, n, static_cast<off_t>(offset));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return;
+            out += got;
+            offset += static_cast<size_t>(got);
+            n -= static_cast<size_t>(got);
+        }
+    }
+
+private:
+    int fd;
+};
+
+class MmapBlockReader {
+public:
+    explicit MmapBlockReader(const std::string& path) : file(MappedFile::open_read(path)) {
+        file.advise(MADV_RANDOM);
+    }
+
+    // memcpy фиксированной длины после встраивания - одна загрузка из отображения
+    void read(size_t offset, char* out, size_t n) {
+        std::memcpy(out, file.data() + offset, n);
+    }
+
+private:
+    MappedFile file;
+};
+
+using BlockReader = std::variant<IfstreamBlockReader, PreadBlockReader, MmapBlockReader>;
+
+#else
+
+using BlockReader = std::variant<IfstreamBlockReader>;
+
+#endif
+
+// Открывает файл выбранным способом; доступ к читателю - через std::visit,
+// так что цикл чтения компилируется отдельно под каждый источник
+inline BlockReader open_block_reader(ReadBackend backend, const std::string& path) {
+    switch (backend) {
+        case ReadBackend::IFSTREAM: return IfstreamBlockReader(path);
+#ifdef __linux__
+        case ReadBackend::PREAD:    return PreadBlockReader(path);
+        case ReadBackend::MMAP:     return MmapBlockReader(path);
+#else
+        default: break;
+#endif
+    }
+    throw std::runtime_error(std::string("способ чтения недоступен: ") + read_backend_name(backend));
+}
+
+#endif
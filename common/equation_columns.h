@@ -0,0 +1,187 @@
+#ifndef EQUATION_COLUMNS_H
+#define EQUATION_COLUMNS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+#ifdef _WIN32
+  #include <malloc.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+  #define EQUATION_COLUMNS_X86 1
+#endif
+
+// Запись о решенном уравнении - то, что раньше хранилось в vector<EquationResult>
+struct EquationResult {
+    double a, b, c;
+    int num_roots;
+    double root1, root2;
+};
+
+// Результаты решения в раскладке SoA: столбцы корней, 8-битный столбец числа корней
+// и (по желанию) столбцы коэффициентов. Без коэффициентов строка занимает 17 байт вместо 48.
+// Память выделяется без инициализации, поэтому страницы попадают в RSS только по мере записи.
+class EquationColumns {
+public:
+    EquationColumns(size_t capacity, bool store_inputs = false)
+        : cap(capacity), with_inputs(store_inputs),
+          x1(alloc<double>(capacity)), x2(alloc<double>(capacity)), n(alloc<uint8_t>(capacity)),
+          a(store_inputs ? alloc<double>(capacity) : nullptr),
+          b(store_inputs ? alloc<double>(capacity) : nullptr),
+          c(store_inputs ? alloc<double>(capacity) : nullptr) {}
+
+    // Решает count уравнений и пишет результаты сразу в столбцы потоковыми (non-temporal)
+    // записями, минуя кэш и промежуточные буферы. solve(a, b, c, x1, x2) возвращает число корней.
+    // Строки идут группами по 8: столбцы выровнены по 64 байтам, поэтому группа double
+    // заполняет строку кэша целиком, а 8 счетчиков корней уходят одной 64-битной записью.
+    // Коэффициенты пишутся, только если столбцы коэффициентов хранятся.
+    template <typename Solve>
+    void solve_append(const double* as, const double* bs, const double* cs, size_t count, Solve&& solve) {
+        if (count > cap - rows) throw std::length_error("EquationColumns: capacity exceeded");
+        size_t i = 0;
+        for (; i < count && (rows + i) % 8 != 0; ++i) {
+            solve_row(as, bs, cs, i, solve);
+        }
+        for (; i + 8 <= count; i += 8) {
+            uint64_t packed = 0;
+            for (size_t j = 0; j < 8; ++j) {
+                size_t row = rows + i + j;
+                double r1, r2;
+                int k = solve(as[i + j], bs[i + j], cs[i + j], r1, r2);
+                stream_store(x1.get() + row, r1);
+                stream_store(x2.get() + row, r2);
+                packed |= static_cast<uint64_t>(static_cast<uint8_t>(k)) << (8 * j);
+                if (with_inputs) {
+                    stream_store(a.get() + row, as[i + j]);
+                    stream_store(b.get() + row, bs[i + j]);
+                    stream_store(c.get() + row, cs[i + j]);
+                }
+            }
+            stream_store(n.get() + rows + i, packed);
+        }
+        for (; i < count; ++i) {
+            solve_row(as, bs, cs, i, solve);
+        }
+        rows += count;
+    }
+
+    // Делает потоковые записи видимыми для последующих чтений
+    void finish() {
+#ifdef EQUATION_COLUMNS_X86
+        _mm_sfence();
+#endif
+    }
+
+    EquationResult operator[](size_t i) const {
+        double nan = std::nan("");
+        return {with_inputs ? a[i] : nan, with_inputs ? b[i] : nan, with_inputs ? c[i] : nan,
+                n[i], x1[i], x2[i]};
+    }
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = EquationResult;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = EquationResult;
+
+        const_iterator() = default;
+        const_iterator(const EquationColumns* owner, size_t index) : owner(owner), index(index) {}
+        EquationResult operator*() const { return (*owner)[index]; }
+        const_iterator& operator++() { ++index; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++index; return old; }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+    private:
+        const EquationColumns* owner = nullptr;
+        size_t index = 0;
+    };
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, rows}; }
+
+    size_t size() const { return rows; }
+    size_t capacity() const { return cap; }
+    bool stores_inputs() const { return with_inputs; }
+
+    const double* root1_column() const { return x1.get(); }
+    const double* root2_column() const { return x2.get(); }
+    const uint8_t* num_roots_column() const { return n.get(); }
+    const double* a_column() const { return a.get(); }
+    const double* b_column() const { return b.get(); }
+    const double* c_column() const { return c.get(); }
+
+    // Объем памяти под столбцы при полной загрузке
+    size_t bytes() const {
+        return cap * (2 * sizeof(double) + sizeof(uint8_t) + (with_inputs ? 3 * sizeof(double) : 0));
+    }
+
+private:
+    struct FreeDeleter {
+        void operator()(void* p) const {
+#ifdef _WIN32
+            _aligned_free(p);
+#else
+            std::free(p);
+#endif
+        }
+    };
+    template <typename T> using Column = std::unique_ptr<T[], FreeDeleter>;
+
+    // Выравнивание по строке кэша, чтобы потоковые записи шли целыми строками
+    template <typename T>
+    static Column<T> alloc(size_t count) {
+        size_t bytes = (count * sizeof(T) + 63) / 64 * 64;
+#ifdef _WIN32
+        void* p = _aligned_malloc(bytes == 0 ? 64 : bytes, 64);  // в CRT Windows нет aligned_alloc
+#else
+        void* p = std::aligned_alloc(64, bytes == 0 ? 64 : bytes);
+#endif
+        if (p == nullptr) throw std::bad_alloc();
+        return Column<T>(static_cast<T*>(p));
+    }
+
+    // Строка rows + i обычными записями - для начала и хвоста, не кратных группе
+    template <typename Solve>
+    void solve_row(const double* as, const double* bs, const double* cs, size_t i, Solve& solve) {
+        size_t row = rows + i;
+        n[row] = static_cast<uint8_t>(solve(as[i], bs[i], cs[i], x1[row], x2[row]));
+        if (with_inputs) {
+            a[row] = as[i];
+            b[row] = bs[i];
+            c[row] = cs[i];
+        }
+    }
+
+    // 8 байт по выровненному адресу через movnti
+    template <typename T>
+    static void stream_store(void* dst, T value) {
+        static_assert(sizeof(T) == 8, "stream_store: 8-byte values only");
+#if defined(__x86_64__)
+        long long bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        _mm_stream_si64(static_cast<long long*>(dst), bits);
+#else
+        std::memcpy(dst, &value, sizeof(value));
+#endif
+    }
+
+    size_t cap, rows = 0;
+    bool with_inputs;
+    Column<double> x1, x2;
+    Column<uint8_t> n;
+    Column<double> a, b, c;
+};
+
+#endif
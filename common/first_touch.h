@@ -0,0 +1,187 @@
+#ifndef FIRST_TOUCH_H
+#define FIRST_TOUCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+  #include <sched.h>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#else
+  #include <cstdlib>
+#endif
+
+// Аллокатор для первого касания: память выделяется через mmap и не инициализируется,
+// поэтому vector<T, FirstTouchAllocator<T>>(n) не трогает страницы. Страница попадает
+// на узел NUMA того потока, который первым в нее запишет.
+template <typename T>
+struct FirstTouchAllocator {
+    using value_type = T;
+
+    FirstTouchAllocator() = default;
+    template <typename U> FirstTouchAllocator(const FirstTouchAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+#ifdef __linux__
+        void* p = ::mmap(nullptr, n * sizeof(T), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        return static_cast<T*>(p);
+#else
+        void* p = std::malloc(n * sizeof(T));
+        if (p == nullptr) throw std::bad_alloc();
+        return static_cast<T*>(p);
+#endif
+    }
+
+    void deallocate(T* p, size_t n) {
+#ifdef __linux__
+        ::munmap(p, n * sizeof(T));
+#else
+        (void)n;
+        std::free(p);
+#endif
+    }
+
+    // Инициализация по умолчанию вместо обнуления: для double это отсутствие записи
+    template <typename U>
+    void construct(U* p) { ::new (static_cast<void*>(p)) U; }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(static_cast<Args&&>(args)...); }
+
+    template <typename U> bool operator==(const FirstTouchAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const FirstTouchAllocator<U>&) const { return false; }
+};
+
+// Узлы NUMA и их процессоры по /sys/devices/system/node; без NUMA - один узел со всеми CPU
+struct NumaTopology {
+    std::vector<std::vector<int>> node_cpus;
+
+    static NumaTopology detect() {
+        NumaTopology topo;
+        for (int node = 0; ; ++node) {
+            std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!in) break;
+            std::string list;
+            std::getline(in, list);
+            topo.node_cpus.push_back(parse_cpulist(list));
+        }
+        if (topo.node_cpus.empty()) {
+            std::vector<int> all;
+#ifdef __linux__
+            long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+#else
+            long n = 1;
+#endif
+            for (int cpu = 0; cpu < n; ++cpu) all.push_back(cpu);
+            topo.node_cpus.push_back(all);
+        }
+        return topo;
+    }
+
+    int nodes() const { return static_cast<int>(node_cpus.size()); }
+
+    int node_of_cpu(int cpu) const {
+        for (int node = 0; node < nodes(); ++node) {
+            for (int c : node_cpus[node]) {
+                if (c == cpu) return node;
+            }
+        }
+        return -1;
+    }
+
+    // Формат "0-3,8,10-11"
+    static std::vector<int> parse_cpulist(const std::string& list) {
+        std::vector<int> cpus;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            if (range.empty()) continue;
+            size_t dash = range.find('-');
+            int lo = std::stoi(range.substr(0, dash));
+            int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+            for (int cpu = lo; cpu <= hi; ++cpu) cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+};
+
+enum class ThreadBinding { NONE, COMPACT, SCATTER };
+
+// Порядок CPU для потоков 0, 1, 2, ...: compact заполняет узел за узлом,
+// scatter раскладывает соседние потоки по разным узлам
+inline std::vector<int> binding_order(const NumaTopology& topo, ThreadBinding binding) {
+    std::vector<int> order;
+    if (binding == ThreadBinding::COMPACT) {
+        for (const auto& cpus : topo.node_cpus) order.insert(order.end(), cpus.begin(), cpus.end());
+    } else if (binding == ThreadBinding::SCATTER) {
+        for (size_t k = 0; ; ++k) {
+            bool any = false;
+            for (const auto& cpus : topo.node_cpus) {
+                if (k < cpus.size()) {
+                    order.push_back(cpus[k]);
+                    any = true;
+                }
+            }
+            if (!any) break;
+        }
+    }
+    return order;
+}
+
+inline bool pin_current_thread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+inline int current_cpu() {
+#ifdef __linux__
+    return ::sched_getcpu();
+#else
+    return 0;
+#endif
+}
+
+// Число страниц массива на каждом узле (move_pages в режиме запроса, без libnuma).
+// Последний элемент - страницы, которые еще не размещены или узел которых неизвестен.
+inline std::vector<size_t> pages_per_node(const void* data, size_t bytes, int nodes) {
+    std::vector<size_t> counts(nodes + 1, 0);
+#ifdef SYS_move_pages
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    uintptr_t first = reinterpret_cast<uintptr_t>(data) / page * page;
+    uintptr_t last = reinterpret_cast<uintptr_t>(data) + bytes;
+    const size_t batch = 4096;
+    std::vector<void*> pages;
+    std::vector<int> status(batch);
+    for (uintptr_t addr = first; addr < last;) {
+        pages.clear();
+        for (; addr < last && pages.size() < batch; addr += page) {
+            pages.push_back(reinterpret_cast<void*>(addr));
+        }
+        long rc = ::syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0);
+        for (size_t i = 0; i < pages.size(); ++i) {
+            int node = rc == 0 ? status[i] : -1;
+            ++counts[(node >= 0 && node < nodes) ? node : nodes];
+        }
+    }
+#else
+    (void)data;
+    (void)bytes;
+#endif
+    return counts;
+}
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+  // Подсказки порядка доступа для advise(); в Windows madvise нет, и они игнорируются
+  #ifndef MADV_NORMAL
+    #define MADV_NORMAL 0
+    #define MADV_RANDOM 1
+    #define MADV_SEQUENTIAL 2
+    #define MADV_WILLNEED 3
+    #define MADV_DONTNEED 4
+  #endif
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+// Файл, отображенный в память целиком: POSIX mmap или, под Windows, CreateFileMapping.
+// Только перемещение, снятие отображения в деструкторе.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    // Только чтение; пустой файл дает data() == nullptr и size() == 0
+    static MappedFile open_read(const std::string& path) {
+        MappedFile file;
+        file.writable = false;
+#ifdef _WIN32
+        file.handle = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file.handle == INVALID_HANDLE_VALUE) fail("CreateFile", path);
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(file.handle, &size)) fail("GetFileSizeEx", path);
+        file.length = static_cast<size_t>(size.QuadPart);
+#else
+        file.fd = ::open(path.c_str(), O_RDONLY);
+        if (file.fd < 0) fail("open", path);
+        struct stat st;
+        if (::fstat(file.fd, &st) != 0) fail("fstat", path);
+        file.length = static_cast<size_t>(st.st_size);
+#endif
+        file.map(path);
+        return file;
+    }
+
+    // Создает (или обрезает) файл размером size байт для записи через память
+    static MappedFile create(const std::string& path, size_t size) {
+        MappedFile file;
+        file.writable = true;
+        file.length = size;
+#ifdef _WIN32
+        file.handle = ::CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file.handle == INVALID_HANDLE_VALUE) fail("CreateFile", path);
+        // Размер задает CreateFileMapping в map()
+#else
+        file.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file.fd < 0) fail("open", path);
+        if (::ftruncate(file.fd, static_cast<off_t>(size)) != 0) fail("ftruncate", path);
+#endif
+        file.map(path);
+        return file;
+    }
+
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            swap(other);
+        }
+        return *this;
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    char* data() { return ptr; }
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+
+    // Подсказка ядру о порядке доступа (MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED ...)
+    void advise(int advice) const {
+#ifdef _WIN32
+        (void)advice;
+#else
+        if (ptr != nullptr) ::madvise(ptr, length, advice);
+#endif
+    }
+
+    // Снимает отображение и, для записываемого файла, обрезает его до final_size байт
+    void close(size_t final_size) {
+        bool shrink = writable && final_size < length;
+#ifdef _WIN32
+        if (ptr != nullptr) ::UnmapViewOfFile(ptr);
+        ptr = nullptr;
+        if (mapping != nullptr) ::CloseHandle(mapping);
+        mapping = nullptr;
+        if (handle != INVALID_HANDLE_VALUE) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(final_size);
+            bool failed = shrink && (!::SetFilePointerEx(handle, end, nullptr, FILE_BEGIN) || !::SetEndOfFile(handle));
+            DWORD error = ::GetLastError();
+            ::CloseHandle(handle);
+            handle = INVALID_HANDLE_VALUE;
+            length = 0;
+            if (failed) {
+                ::SetLastError(error);
+                fail("SetEndOfFile", "");
+            }
+        }
+#else
+        if (ptr != nullptr) ::munmap(ptr, length);
+        ptr = nullptr;
+        if (fd >= 0) {
+            bool failed = shrink && ::ftruncate(fd, static_cast<off_t>(final_size)) != 0;
+            int error = errno;
+            ::close(fd);
+            fd = -1;
+            length = 0;
+            if (failed) {
+                errno = error;
+                fail("ftruncate", "");
+            }
+        }
+#endif
+        length = 0;
+    }
+    void close() { close(length); }
+
+private:
+    // Ошибка при открытии: дескриптор закрывает деструктор временного объекта
+    void map(const std::string& path) {
+        if (length == 0) return;
+#ifdef _WIN32
+        uint64_t size = length;
+        mapping = ::CreateFileMappingA(handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                       static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+        if (mapping == nullptr) fail("CreateFileMapping", path);
+        void* p = ::MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, length);
+        if (p == nullptr) fail("MapViewOfFile", path);
+#else
+        int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* p = ::mmap(nullptr, length, prot, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) fail("mmap", path);
+#endif
+        ptr = static_cast<char*>(p);
+    }
+
+    void swap(MappedFile& other) noexcept {
+#ifdef _WIN32
+        std::swap(handle, other.handle);
+        std::swap(mapping, other.mapping);
+#else
+        std::swap(fd, other.fd);
+#endif
+        std::swap(ptr, other.ptr);
+        std::swap(length, other.length);
+        std::swap(writable, other.writable);
+    }
+
+    [[noreturn]] static void fail(const char* what, const std::string& path) {
+#ifdef _WIN32
+        throw std::runtime_error(std::string(what) + "(" + path + "): ошибка " + std::to_string(::GetLastError()));
+#else
+        throw std::runtime_error(std::string(what) + "(" + path + "): " + std::strerror(errno));
+#endif
+    }
+
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    char* ptr = nullptr;
+    size_t length = 0;
+    bool writable = false;
+};
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+// Аппаратные счетчики через perf_event_open (только Linux, без libpfm/perf).
+// События открываются одной группой (первое открытое - лидер, чтение PERF_FORMAT_GROUP)
+// для текущего потока, только user-space (exclude_kernel), поэтому хватает
+// perf_event_paranoid <= 2. Группа планируется на PMU целиком, так что все значения,
+// и производные вроде IPC, относятся к одному и тому же окну; при мультиплексировании
+// с чужими событиями группа масштабируется как целое.
+// Событие, которое ядро или виртуальная машина не дают открыть или которое не помещается
+// в группу (счетчиков PMU не хватает), просто отсутствует в результатах - остается время.
+//
+// Считается только поток, открывший счетчики: inherit не помог бы пулам и OpenMP, чьи
+// потоки созданы раньше участка. Для многопоточных участков число потоков передается
+// в PerfScope::set_threads / BenchRegistry::add и попадает в JSON рядом со счетчиками.
+
+enum class PerfEvent { CYCLES, INSTRUCTIONS, BRANCHES, BRANCH_MISSES, L1D_MISSES, LLC_MISSES, DTLB_MISSES };
+
+inline const char* perf_event_name(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::CYCLES:        return "cycles";
+        case PerfEvent::INSTRUCTIONS:  return "instructions";
+        case PerfEvent::BRANCHES:      return "branches";
+        case PerfEvent::BRANCH_MISSES: return "branch_misses";
+        case PerfEvent::L1D_MISSES:    return "l1d_misses";
+        case PerfEvent::LLC_MISSES:    return "llc_misses";
+        case PerfEvent::DTLB_MISSES:   return "dtlb_misses";
+    }
+    return "unknown";
+}
+
+inline constexpr std::initializer_list<PerfEvent> ALL_PERF_EVENTS = {
+    PerfEvent::CYCLES, PerfEvent::INSTRUCTIONS, PerfEvent::BRANCHES, PerfEvent::BRANCH_MISSES,
+    PerfEvent::L1D_MISSES, PerfEvent::LLC_MISSES, PerfEvent::DTLB_MISSES};
+
+class PerfCounters {
+public:
+    explicit PerfCounters(std::initializer_list<PerfEvent> events = ALL_PERF_EVENTS) {
+#ifdef __linux__
+        for (PerfEvent event : events) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            config_event(event, attr);
+            bool leader = counters.empty();
+            attr.disabled = leader ? 1 : 0;  // группа включается и выключается через лидера
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int group_fd = leader ? -1 : counters.front().fd;
+            int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+            if (fd < 0) continue;
+            counters.push_back({event, fd, 0});
+        }
+#else
+        (void)events;
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (const Counter& c : counters) ::close(c.fd);
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return !counters.empty(); }
+
+    void start() {
+#ifdef __linux__
+        if (counters.empty()) return;
+        ::ioctl(counters.front().fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(counters.front().fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Останавливает группу и читает все значения одним read() у лидера:
+    // nr, time_enabled, time_running, затем значения в порядке открытия.
+    // Если группа ни разу не попала на PMU (time_running == 0), значения обнуляются.
+    void stop() {
+#ifdef __linux__
+        if (counters.empty()) return;
+        ::ioctl(counters.front().fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        std::vector<uint64_t> buf(3 + counters.size(), 0);
+        ssize_t want = static_cast<ssize_t>(buf.size() * sizeof(uint64_t));
+        if (::read(counters.front().fd, buf.data(), static_cast<size_t>(want)) != want || buf[0] != counters.size()) {
+            return;
+        }
+        double scale = buf[2] > 0 ? static_cast<double>(buf[1]) / buf[2] : 0.0;
+        for (size_t k = 0; k < counters.size(); ++k) {
+            counters[k].value = static_cast<uint64_t>(buf[3 + k] * scale);
+        }
+#endif
+    }
+
+    std::optional<uint64_t> value(PerfEvent event) const {
+        for (const Counter& c : counters) {
+            if (c.event == event) return c.value;
+        }
+        return std::nullopt;
+    }
+
+    std::vector<std::pair<PerfEvent, uint64_t>> values() const {
+        std::vector<std::pair<PerfEvent, uint64_t>> out;
+        for (const Counter& c : counters) out.emplace_back(c.event, c.value);
+        return out;
+    }
+
+private:
+    struct Counter {
+        PerfEvent event;
+        int fd;
+        uint64_t value;
+    };
+
+#ifdef __linux__
+    static void config_event(PerfEvent event, perf_event_attr& attr) {
+        auto cache_miss = [](uint64_t cache) {
+            return cache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) | (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+        };
+        attr.type = PERF_TYPE_HARDWARE;
+        switch (event) {
+            case PerfEvent::CYCLES:        attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+            case PerfEvent::INSTRUCTIONS:  attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case PerfEvent::BRANCHES:      attr.config = PERF_COUNT_HW_BRANCH_INSTRUCTIONS; break;
+            case PerfEvent::BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+            case PerfEvent::L1D_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+                break;
+            case PerfEvent::LLC_MISSES:    attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+            case PerfEvent::DTLB_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache_miss(PERF_COUNT_HW_CACHE_DTLB);
+                break;
+        }
+    }
+#endif
+
+    std::vector<Counter> counters;
+};
+
+// Результат одного измеренного участка
+struct PerfSample {
+    std::string name;
+    double seconds = 0.0;
+    std::vector<std::pair<PerfEvent, uint64_t>> counters;  // пусто, если счетчики недоступны
+    unsigned threads = 1;  // потоков на участке; счетчики всегда только по вызывающему
+
+    std::optional<uint64_t> value(PerfEvent event) const {
+        for (const auto& [e, v] : counters) {
+            if (e == event) return v;
+        }
+        return std::nullopt;
+    }
+
+    std::string to_json() const {
+        std::ostringstream out;
+        out.precision(9);
+        out << "{\"name\": \"" << json_escape(name) << "\", \"seconds\": " << seconds << ", \"counters\": {";
+        for (size_t i = 0; i < counters.size(); ++i) {
+            out << (i ? ", " : "") << "\"" << perf_event_name(counters[i].first) << "\": " << counters[i].second;
+        }
+        out << "}";
+        if (threads > 1) out << ", \"threads\": " << threads << ", \"counters_scope\": \"calling_thread\"";
+        auto cycles = value(PerfEvent::CYCLES), instructions = value(PerfEvent::INSTRUCTIONS);
+        auto branches = value(PerfEvent::BRANCHES), branch_misses = value(PerfEvent::BRANCH_MISSES);
+        if (cycles && instructions && *cycles > 0) {
+            out << ", \"ipc\": " << static_cast<double>(*instructions) / *cycles;
+        }
+        if (branches && branch_misses && *branches > 0) {
+            out << ", \"branch_miss_rate\": " << static_cast<double>(*branch_misses) / *branches;
+        }
+        out << "}";
+        return out.str();
+    }
+
+    static std::string json_escape(const std::string& s) {
+        std::string out;
+        for (char ch : s) {
+            if (ch == '"' || ch == '\\') {
+                out += '\\';
+                out += ch;
+            } else if (static_cast<unsigned char>(ch) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                out += buf;
+            } else {
+                out += ch;
+            }
+        }
+        return out;
+    }
+};
+
+// Журнал участков программы. Если задана переменная окружения PERF_JSON, глобальный
+// журнал при завершении программы записывает туда JSON: {"samples": [...]}.
+class PerfLog {
+public:
+    static PerfLog& global() {
+        static PerfLog log(std::getenv("PERF_JSON") ? std::getenv("PERF_JSON") : "");
+        return log;
+    }
+
+    explicit PerfLog(std::string path = "") : path(std::move(path)) {}
+
+    ~PerfLog() {
+        if (!path.empty()) write_json(path);
+    }
+
+    void add(PerfSample sample) {
+        std::lock_guard<std::mutex> lock(mutex);
+        samples.push_back(std::move(sample));
+    }
+
+    std::string to_json() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string out = "{\"samples\": [";
+        for (size_t i = 0; i < samples.size(); ++i) {
+            out += (i ? ",\n  " : "\n  ") + samples[i].to_json();
+        }
+        out += samples.empty() ? "]}\n" : "\n]}\n";
+        return out;
+    }
+
+    void write_json(const std::string& file) const {
+        std::ofstream out(file);
+        out << to_json();
+    }
+
+private:
+    std::string path;
+    mutable std::mutex mutex;
+    std::vector<PerfSample> samples;
+};
+
+// Измеряет участок от конструктора до stop() (или до деструктора) и кладет результат в журнал.
+// Счетчики считают только текущий поток: для участков с пулом потоков это поток-координатор,
+// и такой участок помечается через set_threads.
+class PerfScope {
+public:
+    explicit PerfScope(std::string name, PerfLog& log = PerfLog::global(),
+                       std::initializer_list<PerfEvent> events = ALL_PERF_EVENTS)
+        : log(log), counters(events) {
+        sample.name = std::move(name);
+        counters.start();
+        start = std::chrono::steady_clock::now();
+    }
+
+    ~PerfScope() {
+        if (!stopped) stop();
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+    // Участок выполняют threads потоков; в JSON счетчики помечаются как относящиеся к одному
+    void set_threads(unsigned threads) { sample.threads = threads; }
+
+    const PerfSample& stop() {
+        if (!stopped) {
+            auto end = std::chrono::steady_clock::now();
+            counters.stop();
+            stopped = true;
+            sample.seconds = std::chrono::duration<double>(end - start).count();
+            sample.counters = counters.values();
+            log.add(sample);
+        }
+        return sample;
+    }
+
+private:
+    PerfLog& log;
+    PerfCounters counters;
+    PerfSample sample;
+    std::chrono::steady_clock::time_point start;
+    bool stopped = false;
+};
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+  #define PHILOX_X86 1
+#endif
+
+// Счетчиковый генератор Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// Число с номером k потока вычисляется напрямую из (seed, k), без общего состояния,
+// поэтому любой кусок потока можно получить в любом потоке и в любом порядке.
+// Блок с номером j дает два числа double: с номерами 2j и 2j + 1.
+//
+// fill() заполняет буфер, продвигая текущую позицию потока, generate() - то же по явной позиции.
+// При наличии AVX2 за одну итерацию считается 8 блоков (16 чисел), результат побитово совпадает
+// со скалярным путем.
+class PhiloxGenerator {
+public:
+    using Block = std::array<uint32_t, 4>;
+
+    explicit PhiloxGenerator(uint64_t seed, uint64_t position = 0)
+        : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}, position(position) {}
+
+    // 128 случайных бит блока с номером index
+    Block block(uint64_t index) const {
+        Block ctr = {static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), 0, 0};
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = uint64_t(M0) * ctr[0];
+            uint64_t p1 = uint64_t(M1) * ctr[2];
+            ctr = {uint32_t(p1 >> 32) ^ ctr[1] ^ k0, uint32_t(p1),
+                   uint32_t(p0 >> 32) ^ ctr[3] ^ k1, uint32_t(p0)};
+            k0 += W0;
+            k1 += W1;
+        }
+        return ctr;
+    }
+
+    // k-е число потока, равномерное на [lo, hi)
+    double uniform(uint64_t k, double lo, double hi) const {
+        Block bits = block(k / 2);
+        return UniformMap{lo, hi - lo}(to_unit(bits[2 * (k % 2)], bits[2 * (k % 2) + 1]));
+    }
+
+    // Числа потока с номерами [first, first + out.size()), равномерные на [lo, hi)
+    void generate(uint64_t first, std::span<double> out, double lo, double hi) const {
+        generate_mapped(first, out, UniformMap{lo, hi - lo});
+    }
+
+    // То же, но равномерно на [lo, -eps) U [eps, hi): интервал сжимается на 2*eps и значения
+    // правее -eps сдвигаются на 2*eps, без цикла отбраковки. Требуется lo < -eps и eps < hi.
+    void generate_nonzero(uint64_t first, std::span<double> out, double lo, double hi, double eps) const {
+        generate_mapped(first, out, NonZeroMap{lo, hi - lo - 2 * eps, eps});
+    }
+
+    void fill(std::span<double> out, double lo, double hi) {
+        generate(position, out, lo, hi);
+        position += out.size();
+    }
+
+    void fill_nonzero(std::span<double> out, double lo, double hi, double eps) {
+        generate_nonzero(position, out, lo, hi, eps);
+        position += out.size();
+    }
+
+    void seek(uint64_t k) { position = k; }
+    uint64_t tell() const { return position; }
+
+    // 52 старших бита пары слов -> [0, 1) через мантиссу числа из [1, 2)
+    static double to_unit(uint32_t lo_word, uint32_t hi_word) {
+        uint64_t bits = (((uint64_t(hi_word) << 32) | lo_word) >> 12) | ONE_BITS;
+        double one_two;
+        std::memcpy(&one_two, &bits, sizeof(one_two));
+        return one_two - 1.0;
+    }
+
+    static constexpr uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    static constexpr uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+
+private:
+    static constexpr uint64_t ONE_BITS = 0x3FF0000000000000ull;
+
+    struct UniformMap {
+        double lo, range;
+        double operator()(double u) const { return lo + range * u; }
+#ifdef PHILOX_X86
+        __attribute__((target("avx2"))) __m256d operator()(__m256d u) const {
+            return _mm256_add_pd(_mm256_set1_pd(lo), _mm256_mul_pd(_mm256_set1_pd(range), u));
+        }
+#endif
+    };
+
+    struct NonZeroMap {
+        double lo, range, eps;
+        double operator()(double u) const {
+            double x = lo + range * u;
+            return x + (x >= -eps ? 2 * eps : 0.0);
+        }
+#ifdef PHILOX_X86
+        __attribute__((target("avx2"))) __m256d operator()(__m256d u) const {
+            __m256d x = _mm256_add_pd(_mm256_set1_pd(lo), _mm256_mul_pd(_mm256_set1_pd(range), u));
+            __m256d shift = _mm256_and_pd(_mm256_cmp_pd(x, _mm256_set1_pd(-eps), _CMP_GE_OQ),
+                                          _mm256_set1_pd(2 * eps));
+            return _mm256_add_pd(x, shift);
+        }
+#endif
+    };
+
+    template <typename Map>
+    void generate_mapped(uint64_t first, std::span<double> out, Map map) const {
+        double* dst = out.data();
+        size_t n = out.size(), i = 0;
+        if (n > 0 && first % 2 != 0) {
+            Block bits = block(first / 2);
+            dst[i++] = map(to_unit(bits[2], bits[3]));
+        }
+#ifdef PHILOX_X86
+        if (has_avx2()) {
+            i += generate_avx2(first + i, dst + i, n - i, map);
+        }
+#endif
+        for (; i + 2 <= n; i += 2) {
+            Block bits = block((first + i) / 2);
+            dst[i]     = map(to_unit(bits[0], bits[1]));
+            dst[i + 1] = map(to_unit(bits[2], bits[3]));
+        }
+        if (i < n) {
+            Block bits = block((first + i) / 2);
+            dst[i] = map(to_unit(bits[0], bits[1]));
+        }
+    }
+
+#ifdef PHILOX_X86
+    static bool has_avx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    // Старшие 32 бита и младшие 32 бита произведений 8 пар 32-битных слов
+    __attribute__((target("avx2")))
+    static void mulhilo8(__m256i x, __m256i m, __m256i& hi, __m256i& lo) {
+        __m256i even = _mm256_mul_epu32(x, m);
+        __m256i odd  = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
+        hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+        lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    }
+
+    __attribute__((target("avx2")))
+    static __m256d to_unit4(__m256i words) {
+        __m256i bits = _mm256_or_si256(_mm256_srli_epi64(words, 12), _mm256_set1_epi64x(ONE_BITS));
+        return _mm256_sub_pd(_mm256_castsi256_pd(bits), _mm256_set1_pd(1.0));
+    }
+
+    // Обрабатывает 8 блоков (16 чисел) за итерацию, начиная с четной позиции first.
+    // Возвращает, сколько чисел записано; хвост дописывает скалярный путь.
+    template <typename Map>
+    __attribute__((target("avx2")))
+    size_t generate_avx2(uint64_t first, double* dst, size_t n, Map map) const {
+        const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i m0 = _mm256_set1_epi32(static_cast<int>(M0));
+        const __m256i m1 = _mm256_set1_epi32(static_cast<int>(M1));
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            uint64_t index = (first + i) / 2;
+            if (static_cast<uint32_t>(index) > UINT32_MAX - 7) break;  // перенос в старшее слово счетчика
+            __m256i x0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(index)), iota);
+            __m256i x1 = _mm256_set1_epi32(static_cast<int>(index >> 32));
+            __m256i x2 = _mm256_setzero_si256();
+            __m256i x3 = _mm256_setzero_si256();
+            uint32_t k0 = key[0], k1 = key[1];
+            for (int round = 0; round < 10; ++round) {
+                __m256i hi0, lo0, hi1, lo1;
+                mulhilo8(x0, m0, hi0, lo0);
+                mulhilo8(x2, m1, hi1, lo1);
+                __m256i y0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), _mm256_set1_epi32(static_cast<int>(k0)));
+                __m256i y2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), _mm256_set1_epi32(static_cast<int>(k1)));
+                x0 = y0; x1 = lo1; x2 = y2; x3 = lo0;
+                k0 += W0;
+                k1 += W1;
+            }
+            // Слова (x0, x1) дают первое число блока, (x2, x3) - второе; переставляем в порядок потока
+            __m256i a_lo = _mm256_unpacklo_epi32(x0, x1), a_hi = _mm256_unpackhi_epi32(x0, x1);
+            __m256i b_lo = _mm256_unpacklo_epi32(x2, x3), b_hi = _mm256_unpackhi_epi32(x2, x3);
+            __m256i blk04 = _mm256_unpacklo_epi64(a_lo, b_lo), blk15 = _mm256_unpackhi_epi64(a_lo, b_lo);
+            __m256i blk26 = _mm256_unpacklo_epi64(a_hi, b_hi), blk37 = _mm256_unpackhi_epi64(a_hi, b_hi);
+            _mm256_storeu_pd(dst + i,      map(to_unit4(_mm256_permute2x128_si256(blk04, blk15, 0x20))));
+            _mm256_storeu_pd(dst + i + 4,  map(to_unit4(_mm256_permute2x128_si256(blk26, blk37, 0x20))));
+            _mm256_storeu_pd(dst + i + 8,  map(to_unit4(_mm256_permute2x128_si256(blk04, blk15, 0x31))));
+            _mm256_storeu_pd(dst + i + 12, map(to_unit4(_mm256_permute2x128_si256(blk26, blk37, 0x31))));
+        }
+        return i;
+    }
+#endif
+
+    std::array<uint32_t, 2> key;
+    uint64_t position;
+};
+
+#endif
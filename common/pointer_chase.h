@@ -0,0 +1,328 @@
+#ifndef POINTER_CHASE_H
+#define POINTER_CHASE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "bench.h"
+#include "first_touch.h"
+
+#ifdef __linux__
+  #include <sys/mman.h>
+#else
+  #include <cstdlib>
+#endif
+
+// Измерение задержки памяти переходами по указателям: в окне из size байт строится
+// случайная циклическая перестановка строк кэша, и каждое следующее чтение зависит от
+// предыдущего. Предвыборка не угадывает адреса, параллелизма по памяти нет, поэтому
+// нс на переход - это задержка того уровня иерархии, в который помещается окно.
+//
+// Память под окна выделяется одним буфером страницами выбранного размера:
+//   4k  - обычные страницы (MADV_NOHUGEPAGE);
+//   thp - прозрачные огромные страницы 2 МБ (MADV_HUGEPAGE, ядро может отказать);
+//   2m  - явные огромные страницы 2 МБ (MAP_HUGETLB, нужен vm.nr_hugepages);
+//   1g  - явные огромные страницы 1 ГБ (MAP_HUGETLB | MAP_HUGE_1GB).
+
+constexpr size_t CHASE_LINE = 64;
+constexpr size_t CHASE_PAGE = 4096;
+
+enum class ChasePages { SMALL, THP, HUGE_2M, HUGE_1G };
+
+inline const char* chase_pages_name(ChasePages pages) {
+    switch (pages) {
+        case ChasePages::SMALL:   return "4k";
+        case ChasePages::THP:     return "thp";
+        case ChasePages::HUGE_2M: return "2m";
+        case ChasePages::HUGE_1G: return "1g";
+    }
+    return "unknown";
+}
+
+inline std::optional<ChasePages> parse_chase_pages(const std::string& name) {
+    for (ChasePages pages : {ChasePages::SMALL, ChasePages::THP, ChasePages::HUGE_2M, ChasePages::HUGE_1G}) {
+        if (name == chase_pages_name(pages)) return pages;
+    }
+    return std::nullopt;
+}
+
+// Буфер для окон; размер округляется до страницы выбранного размера. Только перемещение.
+class ChaseBuffer {
+public:
+    ChaseBuffer(size_t bytes, ChasePages pages) {
+#ifdef __linux__
+        size_t page = pages == ChasePages::HUGE_1G ? (size_t(1) << 30)
+                    : pages == ChasePages::SMALL   ? CHASE_PAGE
+                                                   : (size_t(2) << 20);
+        length = (bytes + page - 1) / page * page;
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        if (pages == ChasePages::HUGE_2M) flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+        if (pages == ChasePages::HUGE_1G) flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+        void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        ptr = static_cast<char*>(p);
+        if (pages == ChasePages::SMALL) ::madvise(ptr, length, MADV_NOHUGEPAGE);
+        if (pages == ChasePages::THP) ::madvise(ptr, length, MADV_HUGEPAGE);
+#else
+        if (pages != ChasePages::SMALL) throw std::bad_alloc();
+        length = bytes;
+        ptr = static_cast<char*>(std::malloc(length));
+        if (ptr == nullptr) throw std::bad_alloc();
+#endif
+        // Первое касание до измерений, чтобы страничные отказы не попали во время
+        for (size_t i = 0; i < length; i += CHASE_PAGE) ptr[i] = 0;
+    }
+
+    ChaseBuffer(ChaseBuffer&& other) noexcept : ptr(other.ptr), length(other.length) {
+        other.ptr = nullptr;
+        other.length = 0;
+    }
+    ChaseBuffer(const ChaseBuffer&) = delete;
+    ChaseBuffer& operator=(const ChaseBuffer&) = delete;
+    ChaseBuffer& operator=(ChaseBuffer&&) = delete;
+
+    ~ChaseBuffer() {
+        if (ptr == nullptr) return;
+#ifdef __linux__
+        ::munmap(ptr, length);
+#else
+        std::free(ptr);
+#endif
+    }
+
+    char* data() { return ptr; }
+    size_t size() const { return length; }
+
+private:
+    char* ptr = nullptr;
+    size_t length = 0;
+};
+
+// Связывает узлы (адреса внутри буфера) в один цикл в случайном порядке;
+// возвращает начало цикла. В каждом узле хранится указатель на следующий.
+inline void** link_random_cycle(std::vector<char*> nodes, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::shuffle(nodes.begin(), nodes.end(), rng);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        *reinterpret_cast<void**>(nodes[i]) = nodes[(i + 1) % nodes.size()];
+    }
+    return reinterpret_cast<void**>(nodes[0]);
+}
+
+// Цикл по всем строкам кэша окна [base, base + bytes)
+inline void** build_line_cycle(char* base, size_t bytes, uint64_t seed) {
+    std::vector<char*> nodes(std::max<size_t>(1, bytes / CHASE_LINE));
+    for (size_t i = 0; i < nodes.size(); ++i) nodes[i] = base + i * CHASE_LINE;
+    return link_random_cycle(std::move(nodes), seed);
+}
+
+// Цикл по одной строке в каждой из pages страниц 4 КБ. Строка внутри страницы сдвигается,
+// чтобы узлы не попадали в один набор кэша: объем данных мал, растет только число страниц.
+inline void** build_page_cycle(char* base, size_t pages, uint64_t seed) {
+    std::vector<char*> nodes(std::max<size_t>(1, pages));
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i] = base + i * CHASE_PAGE + (i % (CHASE_PAGE / CHASE_LINE)) * CHASE_LINE;
+    }
+    return link_random_cycle(std::move(nodes), seed);
+}
+
+// Средняя задержка перехода, нс. Перед замером цикл проходится целиком (но не больше steps),
+// чтобы окно оказалось в кэше и TLB.
+inline double chase_latency_ns(void** start, size_t cycle_length, size_t steps) {
+    void** p = start;
+    for (size_t i = 0, warm = std::min(cycle_length, steps); i < warm; ++i) p = static_cast<void**>(*p);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < steps; i += 8) {
+        p = static_cast<void**>(*p); p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p); p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p); p = static_cast<void**>(*p);
+        p = static_cast<void**>(*p); p = static_cast<void**>(*p);
+    }
+    auto end = std::chrono::steady_clock::now();
+    do_not_optimize(p);
+    size_t done = (steps + 7) / 8 * 8;
+    return std::chrono::duration<double, std::nano>(end - begin).count() / done;
+}
+
+// Несколько независимых цепочек в одном потоке: переходы разных цепочек не зависят друг
+// от друга, поэтому одновременно в полете до K промахов. K - параметр шаблона, чтобы
+// головы цепочек жили в регистрах.
+constexpr size_t CHASE_MAX_CHAINS = 32;
+
+template <size_t K>
+inline void chase_chains_fixed(void*** heads, size_t steps) {
+    void** p[K];
+    for (size_t c = 0; c < K; ++c) p[c] = heads[c];
+    for (size_t i = 0; i < steps; ++i) {
+        for (size_t c = 0; c < K; ++c) p[c] = static_cast<void**>(*p[c]);
+    }
+    for (size_t c = 0; c < K; ++c) heads[c] = p[c];
+}
+
+template <size_t... K>
+constexpr auto make_chase_chains_table(std::index_sequence<K...>) {
+    return std::array<void (*)(void***, size_t), sizeof...(K)>{&chase_chains_fixed<K + 1>...};
+}
+
+// steps переходов по каждой из chains (1..CHASE_MAX_CHAINS) цепочек; головы сдвигаются
+inline void chase_chains(void*** heads, size_t chains, size_t steps) {
+    static constexpr auto table = make_chase_chains_table(std::make_index_sequence<CHASE_MAX_CHAINS>());
+    table[chains - 1](heads, steps);
+}
+
+// Головы chains цепочек, равномерно расставленные по циклу длины cycle_length:
+// цепочки не догоняют друг друга и вместе покрывают все окно
+inline std::vector<void**> spread_chain_heads(void** start, size_t cycle_length, size_t chains) {
+    std::vector<void**> heads;
+    void** p = start;
+    for (size_t i = 0; i < cycle_length && heads.size() < chains; ++i) {
+        if (i % std::max<size_t>(1, cycle_length / chains) == 0) heads.push_back(p);
+        p = static_cast<void**>(*p);
+    }
+    while (heads.size() < chains) heads.push_back(heads[heads.size() % std::max<size_t>(1, cycle_length)]);
+    return heads;
+}
+
+struct ParallelChaseResult {
+    double seconds;     // от общего старта до завершения последнего потока
+    double accesses;    // всего переходов во всех потоках
+    double per_second() const { return accesses / seconds; }
+    // Каждый переход - промах в свою строку кэша, поэтому байты считаются строками
+    double gbytes_per_second() const { return accesses * CHASE_LINE / seconds / 1e9; }
+};
+
+// threads потоков, у каждого свой буфер bytes байт (первое касание - им самим, привязка compact)
+// и свой случайный цикл с зерном seeds[t]; в каждом потоке chains цепочек по steps переходов.
+// Потоки строят циклы, затем стартуют одновременно.
+inline ParallelChaseResult parallel_chase(size_t threads, size_t chains, size_t bytes, ChasePages pages,
+                                          const std::vector<uint64_t>& seeds, size_t steps) {
+    std::vector<int> order = binding_order(NumaTopology::detect(), ThreadBinding::COMPACT);
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            pin_current_thread(order[t % order.size()]);
+            std::optional<ChaseBuffer> buffer;
+            std::vector<void**> heads;
+            try {
+                buffer.emplace(bytes, pages);
+                void** start = build_line_cycle(buffer->data(), bytes, seeds[t]);
+                heads = spread_chain_heads(start, bytes / CHASE_LINE, chains);
+            } catch (const std::bad_alloc&) {
+                failed = true;
+            }
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            if (heads.empty()) return;
+            chase_chains(heads.data(), chains, steps);
+            for (void** head : heads) do_not_optimize(head);
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    auto begin = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& w : workers) w.join();
+    auto end = std::chrono::steady_clock::now();
+    if (failed) throw std::bad_alloc();
+    return {std::chrono::duration<double>(end - begin).count(), static_cast<double>(threads * chains * steps)};
+}
+
+// Размеры от lo до hi, points_per_octave точек на удвоение, кратные step
+inline std::vector<size_t> log_sweep(size_t lo, size_t hi, int points_per_octave, size_t step) {
+    std::vector<size_t> sizes;
+    for (int k = 0; ; ++k) {
+        double x = lo * std::pow(2.0, static_cast<double>(k) / points_per_octave);
+        if (x > hi * 1.0001) break;
+        size_t s = std::max(step, static_cast<size_t>(x) / step * step);
+        if (sizes.empty() || s != sizes.back()) sizes.push_back(s);
+    }
+    return sizes;
+}
+
+struct LatencyPoint {
+    size_t size;  // байты окна или число страниц
+    double ns;
+};
+
+struct LatencyBoundary {
+    size_t size;       // последний размер до скачка
+    double before_ns;  // задержка на плато до скачка
+    double after_ns;   // задержка после подъема
+};
+
+// Скачки кривой задержки. Кривая сглаживается медианой по трем соседним точкам; скачок -
+// точка больше плато в ratio раз. Подъем продолжается, пока каждая следующая точка растет
+// больше чем на 5%: весь подъем - одна граница, его верх - новое плато.
+inline std::vector<LatencyBoundary> detect_boundaries(const std::vector<LatencyPoint>& points, double ratio = 1.5) {
+    std::vector<LatencyBoundary> found;
+    if (points.empty()) return found;
+    std::vector<double> ns(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        double window[3] = {points[i > 0 ? i - 1 : i].ns, points[i].ns, points[i + 1 < points.size() ? i + 1 : i].ns};
+        std::sort(window, window + 3);
+        ns[i] = window[1];
+    }
+    double plateau = ns[0];
+    for (size_t i = 1; i < ns.size(); ++i) {
+        if (ns[i] <= plateau * ratio) {
+            plateau = std::min(plateau, ns[i]);
+            continue;
+        }
+        LatencyBoundary b{points[i - 1].size, plateau, 0.0};
+        while (i + 1 < ns.size() && ns[i + 1] > ns[i] * 1.05) ++i;
+        b.after_ns = plateau = ns[i];
+        found.push_back(b);
+    }
+    return found;
+}
+
+struct CacheLevel {
+    std::string name;  // L1d, L2, L3 ...
+    size_t bytes;
+};
+
+// Кэши данных cpu0 по /sys/devices/system/cpu/cpu0/cache; пусто, если sysfs недоступен
+inline std::vector<CacheLevel> detect_cache_levels() {
+    std::vector<CacheLevel> levels;
+    for (int index = 0; ; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_in(dir + "level"), type_in(dir + "type"), size_in(dir + "size");
+        if (!level_in || !type_in || !size_in) break;
+        int level = 0;
+        std::string type, size;
+        level_in >> level;
+        type_in >> type;
+        size_in >> size;
+        if (type == "Instruction") continue;
+        size_t bytes = std::stoull(size);
+        if (size.back() == 'K') bytes <<= 10;
+        if (size.back() == 'M') bytes <<= 20;
+        levels.push_back({"L" + std::to_string(level) + (type == "Data" ? "d" : ""), bytes});
+    }
+    return levels;
+}
+
+// Имя уровня для границы окна: кэш из sysfs, емкость которого от половины до четырех размеров
+// окна (при случайной замене строк скачок начинается раньше полной емкости), иначе скорее всего TLB
+inline std::string name_boundary(size_t bytes, const std::vector<CacheLevel>& levels) {
+    for (const CacheLevel& level : levels) {
+        if (bytes * 4 >= level.bytes && bytes <= level.bytes * 2) return level.name;
+    }
+    return "TLB?";
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef QUADRATIC_H
+#define QUADRATIC_H
+
+#include <cmath>
+
+// Ядра решения a*x^2 + b*x + c = 0 с тем же контрактом, что у solve_quadratic из lab7/lab8:
+// возвращают число корней (0, 1, 2), при 0 корней x1 = x2 = 0. Требуется a != 0.
+
+// Классическая формула (-b +- sqrt(D)) / (2a): при b^2 >> 4ac один из корней теряет точность
+inline int solve_quadratic_classic(double a, double b, double c, double &x1, double &x2) {
+    double d = b * b - 4 * a * c;
+    if (d > 0) {
+        double sqrt_d = sqrt(d);
+        x1 = (-b + sqrt_d) / (2 * a);
+        x2 = (-b - sqrt_d) / (2 * a);
+        return 2;
+    } else if (d == 0) {
+        x1 = x2 = -b / (2 * a);
+        return 1;
+    } else {
+        x1 = x2 = 0;
+        return 0;
+    }
+}
+
+// Дискриминант через FMA с поправкой Кахана: ошибка округления 4ac вычисляется точно,
+// поэтому результат верен почти до последнего бита даже при b^2 ~ 4ac
+inline double discriminant_fma(double a, double b, double c) {
+    double w = 4 * a * c;
+    double e = std::fma(-4 * a, c, w);
+    return std::fma(b, b, -w) + e;
+}
+
+// Устойчивая форма q = -0.5 (b + sign(b) sqrt(D)), x1 = q / a, x2 = c / q:
+// сложение идет только с одинаковыми знаками, вычитания близких чисел нет
+template <bool UseFma = false>
+inline int solve_quadratic_stable(double a, double b, double c, double &x1, double &x2) {
+    double d = UseFma ? discriminant_fma(a, b, c) : b * b - 4 * a * c;
+    if (d < 0) {
+        x1 = x2 = 0;
+        return 0;
+    }
+    double q = -0.5 * (b + std::copysign(std::sqrt(d), b));
+    x1 = q / a;
+    x2 = (q != 0) ? c / q : x1;  // q == 0 только при b == 0 и c == 0
+    return d > 0 ? 2 : 1;
+}
+
+// Устойчивая форма с одним делением: r = 1 / (a q), x1 = q^2 r, x2 = c a r.
+// Быстрее двух делений, но добавляет пару округлений к каждому корню
+inline int solve_quadratic_stable_rcp(double a, double b, double c, double &x1, double &x2) {
+    double d = b * b - 4 * a * c;
+    if (d < 0) {
+        x1 = x2 = 0;
+        return 0;
+    }
+    double q = -0.5 * (b + std::copysign(std::sqrt(d), b));
+    if (q == 0) {
+        x1 = x2 = 0;
+        return 1;
+    }
+    double r = 1.0 / (a * q);
+    x1 = q * q * r;
+    x2 = c * a * r;
+    return d > 0 ? 2 : 1;
+}
+
+#endif
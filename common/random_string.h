@@ -0,0 +1,103 @@
+#ifndef RANDOM_STRING_H
+#define RANDOM_STRING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace random_string_detail {
+
+// Символ для 6-битного куска; 62 и 63 отбрасываются, но запись без ветвлений все равно кладет их в out
+constexpr std::array<char, 64> make_table() {
+    std::array<char, 64> table{};
+    size_t k = 0;
+    for (char c = '0'; c <= '9'; ++c) table[k++] = c;
+    for (char c = 'A'; c <= 'Z'; ++c) table[k++] = c;
+    for (char c = 'a'; c <= 'z'; ++c) table[k++] = c;
+    table[62] = table[63] = '0';
+    return table;
+}
+
+inline constexpr std::array<char, 64> TABLE = make_table();
+
+}  // namespace random_string_detail
+
+// Быстрая генерация случайных строк из латинских букв и цифр для данных lab4.
+// Один генератор xoshiro256** (Blackman, Vigna) живет все время генерации и задается seed,
+// поэтому набор данных воспроизводится. Каждое 64-битное число дает 10 кусков по 6 бит;
+// кусок 0..61 переводится в символ по таблице, 62 и 63 отбрасываются (1 из 32), так что
+// все 62 символа равновероятны.
+//
+// next(length) пишет во внутренний буфер и возвращает ссылку на него: память выделяется
+// только при росте длины. Ссылка действительна до следующего вызова next.
+class RandomStringGenerator {
+public:
+    static constexpr size_t ALPHABET_SIZE = 62;
+
+    explicit RandomStringGenerator(uint64_t seed) {
+        // Состояние заполняется через splitmix64, как рекомендуют авторы xoshiro
+        for (uint64_t& word : state) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next_u64() {
+        const uint64_t result = rotl(state[1] * 5, 7) * 9;
+        const uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // Равномерно на [0, n) умножением со сдвигом (Lemire); смещение порядка n / 2^64
+    uint64_t uniform(uint64_t n) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(next_u64()) * n) >> 64);
+    }
+
+    // Заполняет out[0..n) символами алфавита
+    void fill(char* out, size_t n) {
+        size_t pos = 0;
+        // Пока в out есть место на 10 символов, запись без ветвлений:
+        // символ пишется всегда, а позиция сдвигается, только если кусок не отброшен
+        while (pos + CHUNKS_PER_WORD <= n) {
+            uint64_t bits = next_u64();
+            for (size_t i = 0; i < CHUNKS_PER_WORD; ++i, bits >>= 6) {
+                unsigned v = static_cast<unsigned>(bits & 63);
+                out[pos] = random_string_detail::TABLE[v];
+                pos += v < ALPHABET_SIZE;
+            }
+        }
+        while (pos < n) {
+            uint64_t bits = next_u64();
+            for (size_t i = 0; i < CHUNKS_PER_WORD && pos < n; ++i, bits >>= 6) {
+                unsigned v = static_cast<unsigned>(bits & 63);
+                if (v < ALPHABET_SIZE) out[pos++] = random_string_detail::TABLE[v];
+            }
+        }
+    }
+
+    const std::string& next(size_t length) {
+        buffer.resize(length);
+        fill(buffer.data(), length);
+        return buffer;
+    }
+
+private:
+    static constexpr size_t CHUNKS_PER_WORD = 10;
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state[4];
+    std::string buffer;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef RECORD_SCANNER_H
+#define RECORD_SCANNER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+// Разбор файла lab4 (data.txt) без копирования: записи "длина пробел строка\n".
+// Файл отображается в память, строки отдаются как string_view прямо в отображение.
+// По длине из префикса следующая запись находится сразу; если после строки нет '\n'
+// (другой формат конца строки, длина не совпала), конец строки ищется memchr (в glibc - SIMD).
+//
+// В отличие от file >> length >> ws; getline(...), запись нулевой длины ("0 \n")
+// остается отдельной пустой строкой: ws пропустил бы перевод строки и склеил ее со следующей.
+
+namespace record_detail {
+
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+}  // namespace record_detail
+
+// Начало первой записи не раньше pos: pos, если это начало файла или перед ним '\n',
+// иначе позиция после ближайшего '\n'. Нужна для разбора файла с произвольного места.
+inline const char* next_record_start(const char* begin, const char* pos, const char* end) {
+    if (pos <= begin) return begin;
+    if (pos >= end) return end;
+    if (pos[-1] == '\n') return pos;
+    const void* nl = std::memchr(pos, '\n', static_cast<size_t>(end - pos));
+    return nl != nullptr ? static_cast<const char*>(nl) + 1 : end;
+}
+
+// Разбирает одну запись с pos; в str - строка без префикса и перевода строки.
+// Возвращает начало следующей записи.
+inline const char* parse_record(const char* pos, const char* end, std::string_view& str) {
+    size_t length = 0;
+    const char* p = pos;
+    while (p < end && record_detail::is_digit(*p)) length = length * 10 + static_cast<size_t>(*p++ - '0');
+    bool prefixed = p > pos && p < end && *p == ' ';
+    if (prefixed) ++p;
+    if (prefixed && length <= static_cast<size_t>(end - p) &&
+        (p + length == end || p[length] == '\n')) {
+        str = std::string_view(p, length);
+        return p + length == end ? end : p + length + 1;
+    }
+    size_t rest = p < end ? static_cast<size_t>(end - p) : 0;
+    const void* nl = rest > 0 ? std::memchr(p, '\n', rest) : nullptr;
+    const char* line_end = nl != nullptr ? static_cast<const char*>(nl) : p + rest;
+    const char* str_end = line_end > p && line_end[-1] == '\r' ? line_end - 1 : line_end;
+    str = std::string_view(p, static_cast<size_t>(str_end - p));
+    return nl != nullptr ? line_end + 1 : end;
+}
+
+// Вызывает f(string_view) для записей, начинающихся в [pos, end), но не больше limit раз.
+// Возвращает число записей.
+template <typename F>
+size_t scan_records(const char* pos, const char* end, size_t limit, F&& f) {
+    size_t count = 0;
+    std::string_view str;
+    while (pos < end && count < limit) {
+        pos = parse_record(pos, end, str);
+        f(str);
+        ++count;
+    }
+    return count;
+}
+
+// Итог разбора куска: записи, записи с совпадением и байты разобранных записей
+struct ScanCount {
+    size_t records = 0;
+    size_t matches = 0;
+    size_t bytes = 0;
+
+    ScanCount& operator+=(const ScanCount& other) {
+        records += other.records;
+        matches += other.matches;
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+// Параллельный разбор [begin, end): границы кусков по chunk_bytes сдвигаются к началу
+// следующей записи (next_record_start), поэтому каждая запись попадает ровно в один кусок.
+// scan(lo, hi, limit) разбирает записи, начинающиеся в [lo, hi), не больше limit штук.
+// Итоги складываются в порядке кусков; кусок, на котором набирается limit записей,
+// пересчитывается последовательно с остатком лимита - результат как у одного прохода.
+template <typename Scan>
+ScanCount parallel_scan_records(ThreadPool& pool, const char* begin, const char* end, size_t limit,
+                                size_t chunk_bytes, Scan scan) {
+    size_t size = static_cast<size_t>(end - begin);
+    chunk_bytes = std::max<size_t>(1, chunk_bytes);
+    size_t chunks = std::max<size_t>(1, (size + chunk_bytes - 1) / chunk_bytes);
+    std::vector<const char*> bounds(chunks + 1);
+    for (size_t k = 0; k <= chunks; ++k) {
+        bounds[k] = next_record_start(begin, begin + std::min(size, k * chunk_bytes), end);
+    }
+    std::vector<ScanCount> partial(chunks);
+    pool.parallel_for(chunks, [&](size_t k) { partial[k] = scan(bounds[k], bounds[k + 1], limit); });
+
+    ScanCount total;
+    for (size_t k = 0; k < chunks; ++k) {
+        if (total.records + partial[k].records >= limit) {
+            total += scan(bounds[k], bounds[k + 1], limit - total.records);
+            break;
+        }
+        total += partial[k];
+    }
+    return total;
+}
+
+// data.txt, отображенный в память целиком
+class RecordFile {
+public:
+    explicit RecordFile(const std::string& path) : file(MappedFile::open_read(path)) {
+        file.advise(MADV_SEQUENTIAL);
+    }
+
+    const char* begin() const { return file.data(); }
+    const char* end() const { return file.data() + file.size(); }
+    size_t size() const { return file.size(); }
+
+    template <typename F>
+    size_t for_each(size_t limit, F&& f) const {
+        return scan_records(begin(), end(), limit, f);
+    }
+
+private:
+    MappedFile file;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "thread_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+  #define REDUCE_X86 1
+#endif
+
+// Суммирование массивов double:
+//   - несколько независимых аккумуляторов, чтобы не упираться в задержку сложения;
+//   - явный SIMD (AVX2) при наличии, без -ffast-math;
+//   - компенсированный режим (Ноймайер), ошибка почти не зависит от длины массива;
+//   - параллельная свертка деревом по блокам фиксированного размера.
+// Порядок сложений определяется только длиной массива и размером блока, поэтому
+// результат побитово одинаков при любом числе потоков.
+
+enum class SumMode { PLAIN, COMPENSATED };
+
+// Сумма с поправкой: значение = sum + comp
+struct CompensatedSum {
+    double sum = 0.0;
+    double comp = 0.0;
+
+    double value() const { return sum + comp; }
+
+    // Сложение Ноймайера: ошибка округления sum + x накапливается в comp
+    void add(double x) {
+        double t = sum + x;
+        comp += std::fabs(sum) >= std::fabs(x) ? (sum - t) + x : (x - t) + sum;
+        sum = t;
+    }
+
+    void add(const CompensatedSum& other) {
+        add(other.sum);
+        comp += other.comp;
+    }
+};
+
+static constexpr size_t REDUCE_BLOCK = 1 << 16;
+
+namespace reduce_detail {
+
+inline CompensatedSum sum_scalar(const double* p, size_t n) {
+    double acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (int k = 0; k < 8; ++k) acc[k] += p[i + k];
+    }
+    for (size_t k = 0; i + k < n; ++k) acc[k] += p[i + k];
+    double total = ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+    return {total, 0.0};
+}
+
+inline CompensatedSum sum_scalar_compensated(const double* p, size_t n) {
+    CompensatedSum acc[4];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int k = 0; k < 4; ++k) acc[k].add(p[i + k]);
+    }
+    for (size_t k = 0; i + k < n; ++k) acc[k].add(p[i + k]);
+    acc[0].add(acc[1]);
+    acc[2].add(acc[3]);
+    acc[0].add(acc[2]);
+    return acc[0];
+}
+
+#ifdef REDUCE_X86
+
+__attribute__((target("avx2")))
+inline double horizontal_sum(__m256d v) {
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+__attribute__((target("avx2")))
+inline CompensatedSum sum_avx2(const double* p, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(p + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(p + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(p + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(p + i + 12));
+    }
+    double total = horizontal_sum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    CompensatedSum tail = sum_scalar(p + i, n - i);
+    return {total + tail.sum, 0.0};
+}
+
+// Ноймайер по 4 дорожкам в двух независимых аккумуляторах; выбор ветви - через маску
+__attribute__((target("avx2")))
+inline void neumaier_step(__m256d& s, __m256d& c, __m256d x) {
+    const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFll));
+    __m256d t = _mm256_add_pd(s, x);
+    __m256d s_bigger = _mm256_cmp_pd(_mm256_and_pd(s, abs_mask), _mm256_and_pd(x, abs_mask), _CMP_GE_OQ);
+    __m256d if_s = _mm256_add_pd(_mm256_sub_pd(s, t), x);
+    __m256d if_x = _mm256_add_pd(_mm256_sub_pd(x, t), s);
+    c = _mm256_add_pd(c, _mm256_blendv_pd(if_x, if_s, s_bigger));
+    s = t;
+}
+
+__attribute__((target("avx2")))
+inline CompensatedSum sum_avx2_compensated(const double* p, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), c0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        neumaier_step(s0, c0, _mm256_loadu_pd(p + i));
+        neumaier_step(s1, c1, _mm256_loadu_pd(p + i + 4));
+    }
+    alignas(32) double sums[8], comps[8];
+    _mm256_store_pd(sums, s0);
+    _mm256_store_pd(sums + 4, s1);
+    _mm256_store_pd(comps, c0);
+    _mm256_store_pd(comps + 4, c1);
+    CompensatedSum total;
+    for (int k = 0; k < 8; ++k) total.add(CompensatedSum{sums[k], comps[k]});
+    total.add(sum_scalar_compensated(p + i, n - i));
+    return total;
+}
+
+inline bool has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif
+
+}  // namespace reduce_detail
+
+// Сумма одного куска без потоков
+inline CompensatedSum sum_block(const double* p, size_t n, SumMode mode) {
+#ifdef REDUCE_X86
+    if (reduce_detail::has_avx2()) {
+        return mode == SumMode::PLAIN ? reduce_detail::sum_avx2(p, n) : reduce_detail::sum_avx2_compensated(p, n);
+    }
+#endif
+    return mode == SumMode::PLAIN ? reduce_detail::sum_scalar(p, n) : reduce_detail::sum_scalar_compensated(p, n);
+}
+
+inline double sum_array(const double* p, size_t n, SumMode mode = SumMode::PLAIN) {
+    return sum_block(p, n, mode).value();
+}
+
+// Попарная свертка частичных сумм в фиксированном порядке
+inline CompensatedSum combine_tree(std::vector<CompensatedSum> partials, SumMode mode) {
+    if (partials.empty()) return {};
+    for (size_t width = 1; width < partials.size(); width *= 2) {
+        for (size_t i = 0; i + width < partials.size(); i += 2 * width) {
+            if (mode == SumMode::PLAIN) {
+                partials[i].sum += partials[i + width].sum;
+            } else {
+                partials[i].add(partials[i + width]);
+            }
+        }
+    }
+    return partials[0];
+}
+
+// Параллельная сумма: блоки по block элементов раздаются потокам пула, затем дерево.
+// Разбиение на блоки не зависит от числа потоков - отсюда воспроизводимость.
+inline double parallel_sum(ThreadPool& pool, const double* p, size_t n,
+                           SumMode mode = SumMode::PLAIN, size_t block = REDUCE_BLOCK) {
+    size_t blocks = (n + block - 1) / block;
+    std::vector<CompensatedSum> partials(blocks);
+    pool.parallel_for(blocks, [&](size_t k) {
+        size_t begin = k * block;
+        partials[k] = sum_block(p + begin, std::min(block, n - begin), mode);
+    });
+    return combine_tree(std::move(partials), mode).value();
+}
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef RESULT_FILE_H
+#define RESULT_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+// Двоичный столбцовый формат результатов решения уравнений, версия 1 (little-endian):
+//   ResultFileHeader                      64 байта
+//   ResultColumnInfo[column_count]        каталог столбцов
+//   блоки столбцов                        каждый с выравниванием 64 байта
+// Столбцы double хранятся как есть и читаются через mmap без копирования.
+// Столбец числа корней может быть сжат: упаковкой по 2 бита на строку, если все значения
+// меньше 4, иначе RLE (байт значения + длина серии в LEB128), если оно короче. Сжатие идет
+// на месте в отображении, без копии столбца: дополнительная память не зависит от числа строк.
+
+enum class ResultColumn : uint32_t { A = 0, B, C, ROOT1, ROOT2, NUM_ROOTS };
+enum class ColumnEncoding : uint32_t { RAW = 0, RLE = 1, BITPACK2 = 2 };
+
+inline const char* column_encoding_name(ColumnEncoding encoding) {
+    switch (encoding) {
+        case ColumnEncoding::RAW:      return "raw";
+        case ColumnEncoding::RLE:      return "rle";
+        case ColumnEncoding::BITPACK2: return "bitpack2";
+    }
+    return "unknown";
+}
+
+struct ResultFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t rows;
+    uint8_t reserved[40];
+};
+static_assert(sizeof(ResultFileHeader) == 64, "ResultFileHeader must be 64 bytes");
+
+struct ResultColumnInfo {
+    uint32_t id;
+    uint32_t encoding;
+    uint64_t offset;
+    uint64_t bytes;
+};
+static_assert(sizeof(ResultColumnInfo) == 24, "ResultColumnInfo must be 24 bytes");
+
+inline constexpr char RESULT_FILE_MAGIC[8] = {'Q', 'R', 'E', 'S', 'U', 'L', 'T', '\0'};
+inline constexpr uint32_t RESULT_FILE_VERSION = 1;
+
+namespace result_file_detail {
+
+inline size_t align64(size_t n) { return (n + 63) / 64 * 64; }
+
+inline size_t leb128_size(uint64_t value) {
+    size_t n = 1;
+    for (; value >= 0x80; value >>= 7) ++n;
+    return n;
+}
+
+// RLE пишется на место исходных байт. Серия кодируется после того, как прочитана целиком;
+// байты, которые зашли бы на еще не прочитанные строки (серии длины 1 длиннее исходника),
+// ждут в буфере, пока чтение не уйдет вперед. Буфер ограничен RLE_STAGING_MAX байт.
+inline constexpr size_t RLE_STAGING_MAX = size_t(1) << 20;
+
+// Размер RLE для data[0..rows), если он меньше rows и буферу хватает RLE_STAGING_MAX байт;
+// иначе rows (оставить столбец как есть)
+inline size_t rle_in_place_size(const uint8_t* data, size_t rows) {
+    size_t out = 0;
+    for (size_t i = 0; i < rows;) {
+        size_t run = 1;
+        while (i + run < rows && data[i + run] == data[i]) ++run;
+        i += run;
+        out += 1 + leb128_size(run);
+        if (out >= rows || (out > i && out - i > RLE_STAGING_MAX)) return rows;
+    }
+    return out;
+}
+
+// Кодирует RLE на месте; вызывать, только если rle_in_place_size(data, rows) < rows
+inline size_t encode_rle_in_place(uint8_t* data, size_t rows) {
+    std::deque<uint8_t> pending;  // байты для позиций [written, written + pending.size())
+    size_t written = 0;
+    for (size_t i = 0; i < rows;) {
+        uint8_t value = data[i];
+        size_t run = 1;
+        while (i + run < rows && data[i + run] == value) ++run;
+        i += run;
+        pending.push_back(value);
+        for (uint64_t r = run; ; r >>= 7) {
+            pending.push_back(static_cast<uint8_t>((r & 0x7F) | (r >= 0x80 ? 0x80 : 0)));
+            if (r < 0x80) break;
+        }
+        for (; !pending.empty() && written < i; pending.pop_front()) data[written++] = pending.front();
+    }
+    for (; !pending.empty(); pending.pop_front()) data[written++] = pending.front();
+    return written;
+}
+
+// Файл читается с диска, поэтому любые повреждения (длина серии длиннее 64 бит, оборванный
+// LEB128, серии больше числа строк) дают исключение, а не неопределенное поведение
+inline std::vector<uint8_t> decode_rle(std::span<const uint8_t> bytes, size_t rows) {
+    std::vector<uint8_t> out;
+    out.reserve(rows);
+    for (size_t i = 0; i < bytes.size();) {
+        uint8_t value = bytes[i++];
+        uint64_t run = 0;
+        bool terminated = false;
+        for (int shift = 0; i < bytes.size(); shift += 7) {
+            if (shift >= 64) throw std::runtime_error("result file: RLE run length is too long");
+            uint8_t b = bytes[i++];
+            run |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                terminated = true;
+                break;
+            }
+        }
+        if (!terminated) throw std::runtime_error("result file: RLE run length is truncated");
+        if (run > rows - out.size()) throw std::runtime_error("result file: RLE run overflows row count");
+        out.insert(out.end(), run, value);
+    }
+    if (out.size() != rows) throw std::runtime_error("result file: RLE column is truncated");
+    return out;
+}
+
+// Упаковывает значения 0..3 по 2 бита на месте: байт k пишется после чтения строк 4k..4k+3,
+// а k <= 4k, поэтому непрочитанные строки не затираются. Возвращает размер в байтах.
+inline size_t encode_bitpack2_in_place(uint8_t* data, size_t rows) {
+    size_t packed = (rows + 3) / 4;
+    for (size_t k = 0; k < packed; ++k) {
+        uint8_t byte = 0;
+        for (size_t j = 0; j < 4 && 4 * k + j < rows; ++j) {
+            byte |= static_cast<uint8_t>((data[4 * k + j] & 3) << (2 * j));
+        }
+        data[k] = byte;
+    }
+    return packed;
+}
+
+inline std::vector<uint8_t> decode_bitpack2(std::span<const uint8_t> bytes, size_t rows) {
+    if (bytes.size() < (rows + 3) / 4) throw std::runtime_error("result file: packed column is truncated");
+    std::vector<uint8_t> out(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        out[i] = (bytes[i / 4] >> (2 * (i % 4))) & 3;
+    }
+    return out;
+}
+
+}  // namespace result_file_detail
+
+// Пишет файл результатов через отображение в память. Число строк задается заранее
+// (под него размечаются блоки столбцов), фактически записанных строк может быть меньше.
+class ResultFileWriter {
+public:
+    ResultFileWriter(const std::string& path, size_t rows, bool store_inputs, bool compress_counts = true)
+        : capacity(rows), compress(compress_counts) {
+        if (store_inputs) {
+            columns = {ResultColumn::A, ResultColumn::B, ResultColumn::C};
+        }
+        columns.insert(columns.end(), {ResultColumn::ROOT1, ResultColumn::ROOT2, ResultColumn::NUM_ROOTS});
+        size_t offset = result_file_detail::align64(sizeof(ResultFileHeader) + columns.size() * sizeof(ResultColumnInfo));
+        for (ResultColumn id : columns) {
+            size_t bytes = capacity * (id == ResultColumn::NUM_ROOTS ? sizeof(uint8_t) : sizeof(double));
+            directory.push_back({static_cast<uint32_t>(id), static_cast<uint32_t>(ColumnEncoding::RAW), offset, bytes});
+            offset = result_file_detail::align64(offset + bytes);
+        }
+        file = MappedFile::create(path, directory.back().offset + directory.back().bytes);
+    }
+
+    ~ResultFileWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    ResultFileWriter(const ResultFileWriter&) = delete;
+    ResultFileWriter& operator=(const ResultFileWriter&) = delete;
+
+    // Дописывает пакет строк; коэффициенты игнорируются, если файл создан без них
+    void append(std::span<const double> a, std::span<const double> b, std::span<const double> c,
+                std::span<const double> x1, std::span<const double> x2, std::span<const uint8_t> num_roots) {
+        size_t count = num_roots.size();
+        if (count > capacity - rows) throw std::length_error("ResultFileWriter: capacity exceeded");
+        if (count == 0) return;
+        for (const ResultColumnInfo& info : directory) {
+            const void* src = nullptr;
+            switch (static_cast<ResultColumn>(info.id)) {
+                case ResultColumn::A:         src = a.data(); break;
+                case ResultColumn::B:         src = b.data(); break;
+                case ResultColumn::C:         src = c.data(); break;
+                case ResultColumn::ROOT1:     src = x1.data(); break;
+                case ResultColumn::ROOT2:     src = x2.data(); break;
+                case ResultColumn::NUM_ROOTS: src = num_roots.data(); break;
+            }
+            size_t width = static_cast<ResultColumn>(info.id) == ResultColumn::NUM_ROOTS ? 1 : sizeof(double);
+            std::memcpy(file.data() + info.offset + rows * width, src, count * width);
+        }
+        rows += count;
+    }
+
+    // Сжимает столбец числа корней, пишет заголовок и обрезает файл. Повторный вызов ничего не делает.
+    void close() {
+        if (file.data() == nullptr && file.size() == 0) return;
+        for (ResultColumnInfo& info : directory) {
+            if (static_cast<ResultColumn>(info.id) != ResultColumn::NUM_ROOTS) {
+                info.bytes = rows * sizeof(double);
+            }
+        }
+        ResultColumnInfo& counts = directory.back();
+        counts.bytes = rows;
+        if (compress && rows > 1) {
+            uint8_t* raw = reinterpret_cast<uint8_t*>(file.data() + counts.offset);
+            bool fits_two_bits = true;
+            for (size_t i = 0; i < rows; ++i) fits_two_bits &= raw[i] < 4;
+            if (fits_two_bits) {
+                counts.bytes = result_file_detail::encode_bitpack2_in_place(raw, rows);
+                counts.encoding = static_cast<uint32_t>(ColumnEncoding::BITPACK2);
+            } else if (result_file_detail::rle_in_place_size(raw, rows) < rows) {
+                counts.bytes = result_file_detail::encode_rle_in_place(raw, rows);
+                counts.encoding = static_cast<uint32_t>(ColumnEncoding::RLE);
+            }
+        }
+
+        ResultFileHeader header{};
+        std::memcpy(header.magic, RESULT_FILE_MAGIC, sizeof(header.magic));
+        header.version = RESULT_FILE_VERSION;
+        header.column_count = static_cast<uint32_t>(directory.size());
+        header.rows = rows;
+        std::memcpy(file.data(), &header, sizeof(header));
+        std::memcpy(file.data() + sizeof(header), directory.data(), directory.size() * sizeof(ResultColumnInfo));
+        file.close(counts.offset + counts.bytes);
+    }
+
+    size_t size() const { return rows; }
+
+private:
+    size_t capacity, rows = 0;
+    bool compress;
+    std::vector<ResultColumn> columns;
+    std::vector<ResultColumnInfo> directory;
+    MappedFile file;
+};
+
+// Открывает файл результатов через mmap: столбцы double доступны сразу, без разбора и копирования
+class ResultFileReader {
+public:
+    explicit ResultFileReader(const std::string& path) : file(MappedFile::open_read(path)) {
+        if (file.size() < sizeof(ResultFileHeader)) throw std::runtime_error(path + ": not a result file");
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, RESULT_FILE_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error(path + ": not a result file");
+        }
+        if (header.version != RESULT_FILE_VERSION) {
+            throw std::runtime_error(path + ": unsupported result file version " + std::to_string(header.version));
+        }
+        size_t dir_end = sizeof(header) + size_t(header.column_count) * sizeof(ResultColumnInfo);
+        if (dir_end > file.size()) throw std::runtime_error(path + ": truncated column directory");
+        directory.resize(header.column_count);
+        std::memcpy(directory.data(), file.data() + sizeof(header), dir_end - sizeof(header));
+        for (const ResultColumnInfo& info : directory) {
+            if (info.offset > file.size() || info.bytes > file.size() - info.offset) {
+                throw std::runtime_error(path + ": column block is out of file bounds");
+            }
+            if (info.encoding > static_cast<uint32_t>(ColumnEncoding::BITPACK2)) {
+                throw std::runtime_error(path + ": unknown column encoding " + std::to_string(info.encoding));
+            }
+            // Столбцы double читаются прямо из отображения, поэтому должны быть RAW и выровнены
+            if (info.id != static_cast<uint32_t>(ResultColumn::NUM_ROOTS) &&
+                (info.encoding != static_cast<uint32_t>(ColumnEncoding::RAW) || info.offset % alignof(double) != 0)) {
+                throw std::runtime_error(path + ": double column is encoded or misaligned");
+            }
+        }
+    }
+
+    size_t rows() const { return header.rows; }
+    bool has_column(ResultColumn id) const { return find(id) != nullptr; }
+    ColumnEncoding encoding(ResultColumn id) const { return static_cast<ColumnEncoding>(get(id).encoding); }
+    size_t file_size() const { return file.size(); }
+
+    // Столбец double прямо из отображения (A, B, C, ROOT1, ROOT2)
+    std::span<const double> column(ResultColumn id) const {
+        const ResultColumnInfo& info = get(id);
+        if (id == ResultColumn::NUM_ROOTS || info.bytes != rows() * sizeof(double)) {
+            throw std::runtime_error("result file: column is not a raw double column");
+        }
+        return {reinterpret_cast<const double*>(file.data() + info.offset), rows()};
+    }
+
+    // Столбец числа корней, распакованный при необходимости
+    std::vector<uint8_t> num_roots() const {
+        const ResultColumnInfo& info = get(ResultColumn::NUM_ROOTS);
+        std::span<const uint8_t> bytes(reinterpret_cast<const uint8_t*>(file.data() + info.offset), info.bytes);
+        switch (static_cast<ColumnEncoding>(info.encoding)) {
+            case ColumnEncoding::RAW:
+                if (bytes.size() != rows()) throw std::runtime_error("result file: raw column size mismatch");
+                return {bytes.begin(), bytes.end()};
+            case ColumnEncoding::RLE:      return result_file_detail::decode_rle(bytes, rows());
+            case ColumnEncoding::BITPACK2: return result_file_detail::decode_bitpack2(bytes, rows());
+        }
+        throw std::runtime_error("result file: unknown column encoding");
+    }
+
+    void advise(int advice) const { file.advise(advice); }
+
+private:
+    const ResultColumnInfo* find(ResultColumn id) const {
+        for (const ResultColumnInfo& info : directory) {
+            if (info.id == static_cast<uint32_t>(id)) return &info;
+        }
+        return nullptr;
+    }
+    const ResultColumnInfo& get(ResultColumn id) const {
+        const ResultColumnInfo* info = find(id);
+        if (info == nullptr) throw std::runtime_error("result file: column is missing");
+        return *info;
+    }
+
+    MappedFile file;
+    ResultFileHeader header{};
+    std::vector<ResultColumnInfo> directory;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef SOLVER_PIPELINE_H
+#define SOLVER_PIPELINE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "result_file.h"
+
+// Кусок уравнений, который проходит по конвейеру генерация -> решение -> приемник
+struct SolverChunk {
+    size_t first = 0;  // номер первого уравнения куска
+    size_t size = 0;
+    std::vector<double> a, b, c, x1, x2;
+    std::vector<uint8_t> num_roots;
+
+    explicit SolverChunk(size_t capacity)
+        : a(capacity), b(capacity), c(capacity), x1(capacity), x2(capacity), num_roots(capacity) {}
+};
+
+// Приемник готовых кусков. consume() вызывается строго по порядку уравнений из одного потока.
+class ChunkSink {
+public:
+    virtual ~ChunkSink() = default;
+    virtual void consume(const SolverChunk& chunk) = 0;
+    virtual void finish() {}
+};
+
+// Считает уравнения по числу корней
+class CountSink : public ChunkSink {
+public:
+    void consume(const SolverChunk& chunk) override {
+        for (size_t i = 0; i < chunk.size; ++i) {
+            ++counts[chunk.num_roots[i] < 3 ? chunk.num_roots[i] : 0];
+        }
+    }
+    size_t counts[3] = {0, 0, 0};
+};
+
+// Гистограмма корней x1 по равным корзинам на [lo, hi); выпавшие за отрезок идут в крайние корзины
+class HistogramSink : public ChunkSink {
+public:
+    HistogramSink(double lo, double hi, size_t bins) : lo(lo), hi(hi), bins(bins, 0) {}
+    void consume(const SolverChunk& chunk) override {
+        const double scale = bins.size() / (hi - lo);
+        const double last = static_cast<double>(bins.size() - 1);
+        for (size_t i = 0; i < chunk.size; ++i) {
+            if (chunk.num_roots[i] == 0) continue;
+            double pos = std::clamp((chunk.x1[i] - lo) * scale, 0.0, last);
+            ++bins[static_cast<size_t>(pos)];
+        }
+    }
+    double lo, hi;
+    std::vector<size_t> bins;
+};
+
+// Пишет результаты в столбцовый файл (см. result_file.h); rows - максимальное число строк
+class FileSink : public ChunkSink {
+public:
+    FileSink(const std::string& path, size_t rows, bool store_inputs = false)
+        : writer(path, rows, store_inputs) {}
+    void consume(const SolverChunk& chunk) override {
+        writer.append({chunk.a.data(), chunk.size}, {chunk.b.data(), chunk.size}, {chunk.c.data(), chunk.size},
+                      {chunk.x1.data(), chunk.size}, {chunk.x2.data(), chunk.size},
+                      {chunk.num_roots.data(), chunk.size});
+    }
+    void finish() override { writer.close(); }
+private:
+    ResultFileWriter writer;
+};
+
+// Очередь указателей на куски; nullptr означает конец потока.
+// close() будит всех ожидающих: после него pop() возвращает nullptr, а push() ничего не делает
+class ChunkQueue {
+public:
+    void push(SolverChunk* chunk) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed) return;
+            items.push_back(chunk);
+        }
+        ready.notify_one();
+    }
+    SolverChunk* pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !items.empty(); });
+        if (closed) return nullptr;
+        SolverChunk* chunk = items.front();
+        items.pop_front();
+        return chunk;
+    }
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<SolverChunk*> items;
+    bool closed = false;
+};
+
+// Потоков в конвейере: генерация, решение и приемник
+inline constexpr unsigned SOLVER_PIPELINE_THREADS = 3;
+
+// Потоковое решение num уравнений кусками по chunk_size через кольцо из ring_size кусков.
+// Генерация и решение идут в отдельных потоках, приемник - в вызывающем; стадии перекрываются,
+// а память ограничена кольцом независимо от num.
+//   generate(chunk) заполняет chunk.a/b/c для уравнений [chunk.first, chunk.first + chunk.size)
+//   solve(chunk) заполняет chunk.x1/x2/num_roots
+// Исключение любой стадии (в том числе sink.consume) закрывает очереди, остальные стадии
+// выходят, потоки присоединяются, и первое исключение пробрасывается вызывающему.
+// chunk_size == 0 - std::invalid_argument до запуска потоков.
+inline void run_solver_pipeline(size_t num, size_t chunk_size, size_t ring_size,
+                                const std::function<void(SolverChunk&)>& generate,
+                                const std::function<void(SolverChunk&)>& solve,
+                                ChunkSink& sink) {
+    if (chunk_size == 0) throw std::invalid_argument("run_solver_pipeline: chunk_size must be positive");
+    std::vector<SolverChunk> ring(std::max<size_t>(ring_size, 1), SolverChunk(chunk_size));
+    ChunkQueue free_chunks, generated, solved;
+    for (auto& chunk : ring) {
+        free_chunks.push(&chunk);
+    }
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto fail = [&] {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+        free_chunks.close();
+        generated.close();
+        solved.close();
+    };
+
+    std::thread generator, solver;
+    try {
+        generator = std::thread([&] {
+            try {
+                for (size_t first = 0; first < num; first += chunk_size) {
+                    SolverChunk* chunk = free_chunks.pop();
+                    if (chunk == nullptr) return;
+                    chunk->first = first;
+                    chunk->size = std::min(chunk_size, num - first);
+                    generate(*chunk);
+                    generated.push(chunk);
+                }
+                generated.push(nullptr);
+            } catch (...) {
+                fail();
+            }
+        });
+        solver = std::thread([&] {
+            try {
+                while (SolverChunk* chunk = generated.pop()) {
+                    solve(*chunk);
+                    solved.push(chunk);
+                }
+                solved.push(nullptr);
+            } catch (...) {
+                fail();
+            }
+        });
+
+        while (SolverChunk* chunk = solved.pop()) {
+            sink.consume(*chunk);
+            free_chunks.push(chunk);
+        }
+    } catch (...) {
+        fail();
+    }
+    if (generator.joinable()) generator.join();
+    if (solver.joinable()) solver.join();
+    if (error) std::rethrow_exception(error);
+    sink.finish();
+}
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef SUBSTRING_SEARCH_H
+#define SUBSTRING_SEARCH_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+  #define SUBSTRING_X86 1
+#endif
+
+// Поиск подстроки с заранее разобранным образцом:
+//   1 байт      - memchr;
+//   от 2 байт   - фильтр по первому и последнему байту образца на AVX2: за шаг проверяются
+//                 32 позиции, memcmp только для позиций, где совпали оба байта;
+//   без AVX2    - до 32 байт memchr по первому байту и memcmp, от 32 байт - Two-Way
+//                 (Crochemore, Perrin) с пропуском по последнему байту окна, как у Хорспула.
+// Two-Way не больше 2n сравнений при любом тексте. Длинный образец на AVX2 тоже переходит
+// на Two-Way, если проверки ложных кандидатов фильтра стоят больше нескольких проходов по
+// тексту (образцы вида "aaa...ab" на тексте из "a"), так что худший случай линейный.
+// find работает с произвольным диапазоном байт, в том числе со всем отображенным файлом.
+
+class SubstringSearcher {
+public:
+    explicit SubstringSearcher(std::string needle) : pattern(std::move(needle)) {
+        shift.fill(pattern.size());
+        for (size_t i = 0; i + 1 < pattern.size(); ++i) {
+            shift[static_cast<unsigned char>(pattern[i])] = pattern.size() - 1 - i;
+        }
+        factorize();
+    }
+
+    const std::string& needle() const { return pattern; }
+    size_t size() const { return pattern.size(); }
+
+    // Первое вхождение в [begin, end) или end
+    const char* find(const char* begin, const char* end) const {
+        size_t n = static_cast<size_t>(end - begin);
+        size_t k = pattern.size();
+        if (k == 0) return begin;
+        if (k > n) return end;
+        if (k == 1) {
+            const void* hit = std::memchr(begin, pattern[0], n);
+            return hit != nullptr ? static_cast<const char*>(hit) : end;
+        }
+#ifdef SUBSTRING_X86
+        if (has_avx2()) return find_avx2(begin, n);
+#endif
+        if (k >= TWO_WAY_MIN) return find_two_way(begin, n);
+        return find_scalar(begin, n);
+    }
+
+    bool contains(std::string_view text) const {
+        return find(text.data(), text.data() + text.size()) != text.data() + text.size();
+    }
+
+private:
+    static constexpr size_t TWO_WAY_MIN = 32;
+
+    const char* find_scalar(const char* s, size_t n) const {
+        const size_t k = pattern.size();
+        if (n < k) return s + n;
+        const char* last = s + n - k;
+        for (const char* p = s; p <= last;) {
+            const void* hit = std::memchr(p, pattern[0], static_cast<size_t>(last - p) + 1);
+            if (hit == nullptr) break;
+            p = static_cast<const char*>(hit);
+            if (std::memcmp(p + 1, pattern.data() + 1, k - 1) == 0) return p;
+            ++p;
+        }
+        return s + n;
+    }
+
+    // Максимальный суффикс образца в прямом (less = false) или обратном порядке байт:
+    // возвращает длину префикса перед суффиксом, period - период суффикса
+    size_t maximal_suffix(bool less, size_t& period) const {
+        const unsigned char* x = reinterpret_cast<const unsigned char*>(pattern.data());
+        const size_t k = pattern.size();
+        size_t start = 0, j = 1, offset = 0;  // суффикс с start сравнивается с суффиксом с j
+        period = 1;
+        while (j + offset < k) {
+            unsigned char a = x[start + offset], b = x[j + offset];
+            if (a == b) {
+                if (offset + 1 == period) {
+                    j += period;
+                    offset = 0;
+                } else {
+                    ++offset;
+                }
+            } else if (less ? a < b : a > b) {
+                j += offset + 1;
+                offset = 0;
+                period = j - start;
+            } else {
+                start = j++;
+                offset = 0;
+                period = 1;
+            }
+        }
+        return start;
+    }
+
+    // Критическая факторизация образца = u v для Two-Way: split = |u|, period - период образца
+    // (для непериодического - оценка снизу max(|u|, |v|) + 1), memory - сколько байт начала
+    // окна заведомо совпадают после сдвига на период
+    void factorize() {
+        if (pattern.size() < 2) return;
+        size_t p1, p2;
+        size_t s1 = maximal_suffix(false, p1), s2 = maximal_suffix(true, p2);
+        split = s2 > s1 ? s2 : s1;
+        period = s2 > s1 ? p2 : p1;
+        if (period < pattern.size() && std::memcmp(pattern.data(), pattern.data() + period, split) == 0) {
+            memory = pattern.size() - period;
+        } else {
+            period = std::max(split, pattern.size() - split) + 1;
+            memory = 0;
+        }
+    }
+
+    const char* find_two_way(const char* s, size_t n) const {
+        const size_t k = pattern.size();
+        const char last_byte = pattern[k - 1];
+        size_t mem = 0;
+        for (size_t i = 0; i + k <= n;) {
+            // Пропуск Хорспула по последнему байту окна; сбрасывает память о периоде
+            char c = s[i + k - 1];
+            if (c != last_byte) {
+                i += shift[static_cast<unsigned char>(c)];
+                mem = 0;
+                continue;
+            }
+            // Правая часть v слева направо: при несовпадении сдвиг на пройденное
+            size_t j = std::max(split, mem);
+            while (j < k && pattern[j] == s[i + j]) ++j;
+            if (j < k) {
+                i += j - split + 1;
+                mem = 0;
+                continue;
+            }
+            // Левая часть u справа налево, кроме уже известного префикса
+            j = split;
+            while (j > mem && pattern[j - 1] == s[i + j - 1]) --j;
+            if (j <= mem) return s + i;
+            i += period;
+            mem = memory;
+        }
+        return s + n;
+    }
+
+#ifdef SUBSTRING_X86
+    static bool has_avx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    __attribute__((target("avx2")))
+    const char* find_avx2(const char* s, size_t n) const {
+        const size_t k = pattern.size();
+        const __m256i first = _mm256_set1_epi8(pattern[0]);
+        const __m256i last = _mm256_set1_epi8(pattern[k - 1]);
+        // Байты, сравненные memcmp у ложных кандидатов; для длинного образца при перерасходе - Two-Way
+        size_t wasted = 0;
+        size_t i = 0;
+        for (; i + k - 1 + 32 <= n; i += 32) {
+            __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+            __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + k - 1));
+            __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+            while (mask != 0) {
+                unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+                if (k == 2 || std::memcmp(s + i + bit + 1, pattern.data() + 1, k - 2) == 0) return s + i + bit;
+                mask &= mask - 1;
+                if (k >= TWO_WAY_MIN && (wasted += k) > 4 * (i + bit) + TWO_WAY_SLACK) {
+                    // Все позиции до i + bit включительно уже отброшены
+                    return find_two_way(s + i + bit + 1, n - i - bit - 1);
+                }
+            }
+        }
+        return k >= TWO_WAY_MIN ? find_two_way(s + i, n - i) : find_scalar(s + i, n - i);
+    }
+
+    static constexpr size_t TWO_WAY_SLACK = 1 << 16;
+#endif
+
+    std::string pattern;
+    std::array<size_t, 256> shift;
+    size_t split = 0, period = 1, memory = 0;  // факторизация для Two-Way
+};
+
+#endif
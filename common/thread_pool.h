@@ -0,0 +1,118 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков фиксированного размера для параллельных циклов по кускам работы.
+// Вызывающий поток тоже обрабатывает куски, поэтому ThreadPool(1) работает без дополнительных потоков.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned t = 1; t < threads; ++t) {
+            workers.emplace_back([this, t] { worker_loop(t); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Вызывает body(chunk) для каждого chunk из [0, chunks) и ждет завершения всех кусков.
+    // Куски раздаются динамически, поэтому результат не должен зависеть от того, какой поток что посчитал.
+    void parallel_for(size_t chunks, const std::function<void(size_t)>& body) {
+        parallel_for_worker(chunks, [&body](size_t chunk, unsigned) { body(chunk); });
+    }
+
+    // То же, но body дополнительно получает номер потока в [0, size()), например для поточных буферов.
+    void parallel_for_worker(size_t chunks, const std::function<void(size_t, unsigned)>& body) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &body;
+            job_chunks = chunks;
+            next_chunk.store(0, std::memory_order_relaxed);
+            active = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        run_chunks(body, chunks, 0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+        job = nullptr;
+    }
+
+    // Вызывает body(worker) ровно один раз в каждом потоке пула (worker = 0 - вызывающий поток),
+    // например для привязки потоков к CPU или статического разбиения "кусок k - потоку k".
+    // Поток, выполнивший свой кусок, ждет остальных и поэтому не может взять второй.
+    void run_on_each_thread(const std::function<void(unsigned)>& body) {
+        const unsigned threads = size();
+        std::atomic<unsigned> arrived{0};
+        parallel_for_worker(threads, [&](size_t, unsigned worker) {
+            body(worker);
+            arrived.fetch_add(1, std::memory_order_acq_rel);
+            while (arrived.load(std::memory_order_acquire) < threads) std::this_thread::yield();
+        });
+    }
+
+private:
+    void run_chunks(const std::function<void(size_t, unsigned)>& body, size_t chunks, unsigned worker) {
+        for (size_t chunk; (chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+            body(chunk, worker);
+        }
+    }
+
+    void worker_loop(unsigned worker) {
+        uint64_t seen = 0;
+        for (;;) {
+            const std::function<void(size_t, unsigned)>* body;
+            size_t chunks;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                body = job;
+                chunks = job_chunks;
+            }
+            run_chunks(*body, chunks, worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--active == 0) done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(size_t, unsigned)>* job = nullptr;
+    size_t job_chunks = 0;
+    std::atomic<size_t> next_chunk{0};
+    size_t active = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+#endif
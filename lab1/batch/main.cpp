@@ -0,0 +1,55 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include "solver.h"
+#include "../../common/philox.h"
+#include "../../common/perf_counters.h"
+#include "../../common/bench.h"
+
+#define NUM 100000000
+#define SEED 42
+#define BATCH 4096
+
+
+// Число уравнений с вещественными корнями среди первых NUM уравнений потока
+int count_real_roots() {
+    PhiloxGenerator gen(SEED);
+    std::vector<double> coeffs(3 * BATCH);
+    std::vector<double> a(BATCH), b(BATCH), c(BATCH), x1(BATCH), x2(BATCH);
+    std::vector<uint8_t> roots(BATCH);
+    int count = 0;
+    for (int done = 0; done < NUM; done += BATCH) {
+        int n = std::min(BATCH, NUM - done);
+        // Тот же поток коэффициентов, что и в простой версии, разложенный по столбцам
+        gen.fill({coeffs.data(), size_t(3 * n)}, -100.0, 100.0);
+        for (int i = 0; i < n; ++i) {
+            a[i] = coeffs[3 * i];
+            b[i] = coeffs[3 * i + 1];
+            c[i] = coeffs[3 * i + 2];
+        }
+        solveQuadraticBatch({a.data(), size_t(n)}, {b.data(), size_t(n)}, {c.data(), size_t(n)},
+                            {x1.data(), size_t(n)}, {x2.data(), size_t(n)}, {roots.data(), size_t(n)});
+        for (int i = 0; i < n; ++i) {
+            count += roots[i] != 0;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        BenchRegistry registry;
+        registry.add("lab1/batch", [] { do_not_optimize(count_real_roots()); });
+        return registry.main(argc, argv);
+    }
+    PerfScope perf_scope("lab1/batch");
+    auto start = std::chrono::high_resolution_clock::now();
+    int count = count_real_roots();
+    auto end = std::chrono::high_resolution_clock::now();
+    perf_scope.stop();
+    std::cout << "Kernel: " << solveQuadraticBatchKernel() << "\n";
+    std::cout << "Time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n";
+    std::cout << "Equations with real roots: " << count << std::endl;
+    return 0;
+}
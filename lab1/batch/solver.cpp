@@ -0,0 +1,193 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <tuple>
+#include <optional>
+#include "solver.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+  #define SOLVER_X86 1
+#endif
+
+double Discriminant(double a, double b, double c){
+    return b*b-4*a*c;
+}
+
+double root1(double a, double b, double D){
+    return (-b + sqrt(D))/(2*a);
+}
+
+double root2(double a, double b, double D){
+    return (-b - sqrt(D))/(2*a);
+}
+
+std::optional<std::tuple<double, double>> solveQuadratic(double a, double b, double c){
+    double D = Discriminant(a, b, c);
+    if(D < 0) return std::nullopt;
+    double x1 = root1(a, b, D);
+    double x2 = root2(a, b, D);
+    return (D == 0)? std::make_tuple(x1,x1) : std::make_tuple(x1, x2);
+}
+
+// Все ядра считают по тем же формулам, что и root1/root2, поэтому корни совпадают побитово
+// со скалярной версией. Ветвлений по данным нет: при D < 0 sqrt дает NaN, а число корней
+// собирается из масок сравнений D > 0 и D == 0.
+
+using BatchKernel = void (*)(const double*, const double*, const double*, double*, double*, uint8_t*, size_t);
+
+static void solveBatchScalar(const double* a, const double* b, const double* c,
+                             double* x1, double* x2, uint8_t* roots, size_t n){
+    for (size_t i = 0; i < n; ++i) {
+        double D = Discriminant(a[i], b[i], c[i]);
+        double sd = std::sqrt(D);
+        x1[i] = (-b[i] + sd)/(2*a[i]);
+        x2[i] = (-b[i] - sd)/(2*a[i]);
+        roots[i] = static_cast<uint8_t>((D > 0) * 2 + (D == 0));
+    }
+}
+
+#ifdef SOLVER_X86
+
+// Битовая маска из 4 дорожек -> 4 байта со значениями 0/1
+static constexpr uint32_t nibbleToBytes(unsigned m){
+    return (m & 1u) | ((m >> 1) & 1u) << 8 | ((m >> 2) & 1u) << 16 | ((m >> 3) & 1u) << 24;
+}
+
+static constexpr uint32_t NIBBLE_BYTES[16] = {
+    nibbleToBytes(0),  nibbleToBytes(1),  nibbleToBytes(2),  nibbleToBytes(3),
+    nibbleToBytes(4),  nibbleToBytes(5),  nibbleToBytes(6),  nibbleToBytes(7),
+    nibbleToBytes(8),  nibbleToBytes(9),  nibbleToBytes(10), nibbleToBytes(11),
+    nibbleToBytes(12), nibbleToBytes(13), nibbleToBytes(14), nibbleToBytes(15)
+};
+
+static inline uint32_t rootCounts4(unsigned gt, unsigned eq){
+    return 2 * NIBBLE_BYTES[gt] + NIBBLE_BYTES[eq];
+}
+
+static void solveBatchSse2(const double* a, const double* b, const double* c,
+                           double* x1, double* x2, uint8_t* roots, size_t n){
+    const __m128d four = _mm_set1_pd(4.0);
+    const __m128d two  = _mm_set1_pd(2.0);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d va = _mm_loadu_pd(a + i);
+        __m128d vb = _mm_loadu_pd(b + i);
+        __m128d vc = _mm_loadu_pd(c + i);
+        __m128d D  = _mm_sub_pd(_mm_mul_pd(vb, vb), _mm_mul_pd(_mm_mul_pd(four, va), vc));
+        __m128d sd = _mm_sqrt_pd(D);
+        __m128d nb = _mm_xor_pd(vb, sign);
+        __m128d den = _mm_mul_pd(two, va);
+        _mm_storeu_pd(x1 + i, _mm_div_pd(_mm_add_pd(nb, sd), den));
+        _mm_storeu_pd(x2 + i, _mm_div_pd(_mm_sub_pd(nb, sd), den));
+        unsigned gt = _mm_movemask_pd(_mm_cmpgt_pd(D, zero));
+        unsigned eq = _mm_movemask_pd(_mm_cmpeq_pd(D, zero));
+        uint32_t counts = rootCounts4(gt, eq);
+        std::memcpy(roots + i, &counts, 2);
+    }
+    solveBatchScalar(a + i, b + i, c + i, x1 + i, x2 + i, roots + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void solveBatchAvx2(const double* a, const double* b, const double* c,
+                           double* x1, double* x2, uint8_t* roots, size_t n){
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d two  = _mm256_set1_pd(2.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i);
+        __m256d vb = _mm256_loadu_pd(b + i);
+        __m256d vc = _mm256_loadu_pd(c + i);
+        __m256d D  = _mm256_sub_pd(_mm256_mul_pd(vb, vb), _mm256_mul_pd(_mm256_mul_pd(four, va), vc));
+        __m256d sd = _mm256_sqrt_pd(D);
+        __m256d nb = _mm256_xor_pd(vb, sign);
+        __m256d den = _mm256_mul_pd(two, va);
+        _mm256_storeu_pd(x1 + i, _mm256_div_pd(_mm256_add_pd(nb, sd), den));
+        _mm256_storeu_pd(x2 + i, _mm256_div_pd(_mm256_sub_pd(nb, sd), den));
+        unsigned gt = _mm256_movemask_pd(_mm256_cmp_pd(D, zero, _CMP_GT_OQ));
+        unsigned eq = _mm256_movemask_pd(_mm256_cmp_pd(D, zero, _CMP_EQ_OQ));
+        uint32_t counts = rootCounts4(gt, eq);
+        std::memcpy(roots + i, &counts, 4);
+    }
+    solveBatchScalar(a + i, b + i, c + i, x1 + i, x2 + i, roots + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void solveBatchAvx512(const double* a, const double* b, const double* c,
+                             double* x1, double* x2, uint8_t* roots, size_t n){
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d two  = _mm512_set1_pd(2.0);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512i sign = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ull));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d va = _mm512_loadu_pd(a + i);
+        __m512d vb = _mm512_loadu_pd(b + i);
+        __m512d vc = _mm512_loadu_pd(c + i);
+        __m512d D  = _mm512_sub_pd(_mm512_mul_pd(vb, vb), _mm512_mul_pd(_mm512_mul_pd(four, va), vc));
+        __m512d sd = _mm512_sqrt_pd(D);
+        __m512d nb = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(vb), sign));
+        __m512d den = _mm512_mul_pd(two, va);
+        _mm512_storeu_pd(x1 + i, _mm512_div_pd(_mm512_add_pd(nb, sd), den));
+        _mm512_storeu_pd(x2 + i, _mm512_div_pd(_mm512_sub_pd(nb, sd), den));
+        unsigned gt = _mm512_cmp_pd_mask(D, zero, _CMP_GT_OQ);
+        unsigned eq = _mm512_cmp_pd_mask(D, zero, _CMP_EQ_OQ);
+        uint32_t lo = rootCounts4(gt & 0xF, eq & 0xF);
+        uint32_t hi = rootCounts4(gt >> 4, eq >> 4);
+        std::memcpy(roots + i, &lo, 4);
+        std::memcpy(roots + i + 4, &hi, 4);
+    }
+    solveBatchScalar(a + i, b + i, c + i, x1 + i, x2 + i, roots + i, n - i);
+}
+
+#endif
+
+struct BatchKernelInfo {
+    BatchKernel fn;
+    const char* name;
+};
+
+// Выбор ядра по CPUID. Переменная окружения SOLVER_KERNEL (avx512/avx2/sse2/scalar)
+// позволяет принудительно понизить уровень для сравнения ядер между собой;
+// неизвестное имя или ядро, которого нет на этом процессоре, - ошибка, а не тихий откат.
+static BatchKernelInfo selectBatchKernel(){
+    const char* forced = std::getenv("SOLVER_KERNEL");
+    BatchKernelInfo kernels[4] = {};  // доступные ядра, от лучшего к худшему
+    size_t count = 0;
+#ifdef SOLVER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) kernels[count++] = {solveBatchAvx512, "avx512"};
+    if (__builtin_cpu_supports("avx2")) kernels[count++] = {solveBatchAvx2, "avx2"};
+    kernels[count++] = {solveBatchSse2, "sse2"};
+#endif
+    kernels[count++] = {solveBatchScalar, "scalar"};
+    if (forced == nullptr || *forced == '\0') return kernels[0];
+    for (size_t k = 0; k < count; ++k) {
+        if (std::strcmp(forced, kernels[k].name) == 0) return kernels[k];
+    }
+    bool known = false;
+    for (const char* name : {"avx512", "avx2", "sse2", "scalar"}) known = known || std::strcmp(forced, name) == 0;
+    std::cerr << "SOLVER_KERNEL=" << forced
+              << (known ? ": ядро не поддерживается этим процессором" : ": неизвестное ядро (avx512/avx2/sse2/scalar)")
+              << std::endl;
+    std::exit(EXIT_FAILURE);
+}
+
+static const BatchKernelInfo& batchKernel(){
+    static const BatchKernelInfo kernel = selectBatchKernel();
+    return kernel;
+}
+
+void solveQuadraticBatch(std::span<const double> a, std::span<const double> b, std::span<const double> c,
+                         std::span<double> x1, std::span<double> x2, std::span<uint8_t> roots){
+    batchKernel().fn(a.data(), b.data(), c.data(), x1.data(), x2.data(), roots.data(), a.size());
+}
+
+const char* solveQuadraticBatchKernel(){
+    return batchKernel().name;
+}
@@ -0,0 +1,21 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <cstdint>
+#include <tuple>
+#include <optional>
+#include <span>
+
+std::optional<std::tuple<double, double>> solveQuadratic(double a, double b, double c);
+
+// Пакетное решение уравнений в раскладке SoA.
+// roots[i] - количество корней (0, 1 или 2), при roots[i] == 0 в x1[i] и x2[i] записывается NaN.
+// Все массивы должны быть одной длины.
+void solveQuadraticBatch(std::span<const double> a, std::span<const double> b, std::span<const double> c,
+                         std::span<double> x1, std::span<double> x2, std::span<uint8_t> roots);
+
+// Имя ядра, выбранного по возможностям процессора: "avx512", "avx2", "sse2" или "scalar"
+// (не x86); SOLVER_KERNEL задает ядро явно, неподдерживаемое или неизвестное завершает программу
+const char* solveQuadraticBatchKernel();
+
+#endif
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <tuple>
+#include <optional>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include "../../common/philox.h"
+#include "../../common/thread_pool.h"
+#include "../../common/perf_counters.h"
+#include "../../common/bench.h"
+
+#define NUM 100000000
+#define SEED 42
+#define CHUNK (1 << 20)
+#define BATCH 4096
+
+inline double Discriminant(double a, double b, double c){
+    return b*b-4*a*c;
+}
+
+inline double root1(double a, double b, double D){
+    return (-b + sqrt(D))/(2*a);
+}
+
+inline double root2(double a, double b, double D){
+    return (-b - sqrt(D))/(2*a);
+}
+
+inline std::optional<std::tuple<double, double>> solveQuadratic(double a, double b, double c){
+    double D = Discriminant(a, b, c);
+    if(D < 0) return std::nullopt;
+    double x1 = root1(a, b, D);
+    double x2 = root2(a, b, D);
+    return (D == 0)? std::make_tuple(x1,x1) : std::make_tuple(x1, x2);
+}
+
+
+// Уравнение i берет коэффициенты a, b, c из чисел 3i, 3i+1, 3i+2 счетчикового потока Philox,
+// поэтому результат не зависит ни от числа потоков, ни от порядка обработки кусков:
+// запуск с одним потоком и есть последовательный эталон.
+int count_real_roots(ThreadPool& pool) {
+    PhiloxGenerator gen(SEED);
+    const size_t chunks = (size_t(NUM) + CHUNK - 1) / CHUNK;
+    std::vector<int> chunk_counts(chunks);
+    pool.parallel_for(chunks, [&](size_t chunk) {
+        size_t begin = chunk * CHUNK;
+        size_t end = std::min(begin + CHUNK, size_t(NUM));
+        std::vector<double> coeffs(3 * BATCH);
+        int count = 0;
+        for (size_t first = begin; first < end; first += BATCH) {
+            size_t n = std::min(size_t(BATCH), end - first);
+            gen.generate(3 * first, {coeffs.data(), 3 * n}, -100.0, 100.0);
+            for (size_t i = 0; i < n; ++i) {
+                auto roots = solveQuadratic(coeffs[3 * i], coeffs[3 * i + 1], coeffs[3 * i + 2]);
+                if (roots) count++;
+            }
+        }
+        chunk_counts[chunk] = count;
+    });
+    int count = 0;
+    for (int c : chunk_counts) count += c;
+    return count;
+}
+
+// Запуск: main.exe [потоки]; по умолчанию - все ядра.
+//         main.exe bench [опции bench.h] - пулы из 1, 2, 4, ... потоков до числа ядер
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::unique_ptr<ThreadPool>> pools;
+        BenchRegistry registry;
+        for (unsigned t = 1; ; t = std::min(2 * t, max_threads)) {
+            pools.push_back(std::make_unique<ThreadPool>(t));
+            ThreadPool& pool = *pools.back();
+            registry.add("lab1/parallel/threads=" + std::to_string(t),
+                         [&pool] { do_not_optimize(count_real_roots(pool)); }, t);
+            if (t == max_threads) break;
+        }
+        return registry.main(argc, argv);
+    }
+    unsigned threads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 0;
+    ThreadPool pool(threads);
+
+    PerfScope perf_scope("lab1/parallel");
+    perf_scope.set_threads(pool.size());
+    auto start = std::chrono::high_resolution_clock::now();
+    int count = count_real_roots(pool);
+    auto end = std::chrono::high_resolution_clock::now();
+    perf_scope.stop();
+    std::cout << "Threads: " << pool.size() << "\n";
+    std::cout << "Time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n";
+    std::cout << "Equations with real roots: " << count << std::endl;
+    return 0;
+}
@@ -1,12 +1,17 @@
 #include <iostream>
 #include <cmath>
-#include <random>
+#include <vector>
+#include <string>
 #include <chrono>
 #include <tuple>
 #include <optional>
+#include "../../common/philox.h"
+#include "../../common/perf_counters.h"
+#include "../../common/bench.h"
 
 #define NUM 100000000
 #define SEED 42
+#define BATCH 4096
 
 inline double Discriminant(double a, double b, double c){
     return b*b-4*a*c;
@@ -29,20 +34,34 @@ inline std::optional<std::tuple<double, double>> solveQuadratic(double a, double
 }
 
 
-int main() {
-    std::mt19937 rng(SEED);
-    std::uniform_real_distribution<double> dist(-100.0, 100.0);
+// Число уравнений с вещественными корнями среди первых NUM уравнений потока
+int count_real_roots() {
+    PhiloxGenerator gen(SEED);
+    std::vector<double> coeffs(3 * BATCH);
     int count = 0;
-    auto start = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < NUM; ++i) {
-        double a = dist(rng);
-        double b = dist(rng);
-        double c = dist(rng);
-        auto roots = solveQuadratic(a, b, c);
-        if (roots) count++;
+    for (int done = 0; done < NUM; done += BATCH) {
+        int n = std::min(BATCH, NUM - done);
+        // Коэффициенты уравнения i - числа 3i, 3i+1, 3i+2 потока
+        gen.fill({coeffs.data(), size_t(3 * n)}, -100.0, 100.0);
+        for (int i = 0; i < n; ++i) {
+            auto roots = solveQuadratic(coeffs[3 * i], coeffs[3 * i + 1], coeffs[3 * i + 2]);
+            if (roots) count++;
+        }
     }
+    return count;
+}
 
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        BenchRegistry registry;
+        registry.add("lab1/simple", [] { do_not_optimize(count_real_roots()); });
+        return registry.main(argc, argv);
+    }
+    PerfScope perf_scope("lab1/simple");
+    auto start = std::chrono::high_resolution_clock::now();
+    int count = count_real_roots();
     auto end = std::chrono::high_resolution_clock::now();
+    perf_scope.stop();
     std::cout << "Time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n";
     std::cout << "Equations with real roots: " << count << std::endl;
     return 0;
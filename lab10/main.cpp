@@ -3,7 +3,19 @@
 #include <random>
 #include <chrono>
 #include <cstdlib>
+#include <algorithm>
+#ifdef _WIN32
 #include <windows.h>
+#endif
+#include <string>
+#include <cstring>
+#include "../common/perf_counters.h"
+#include "../common/bench.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define HAVE_X86 1
+#endif
 
 #if (defined(__GNUC__) && (__GNUC__ >= 3)) || (defined(__INTEL_COMPILER)) || defined(__clang__)
     #define likely(expr)   (__builtin_expect(static_cast<bool>(expr), true))
@@ -18,6 +30,7 @@ using namespace std::chrono;
 
 static const size_t N = 500'000'000;
 static const int REPEATS = 3;
+static const size_t STRIDE = 1000;  // каждый STRIDE-й элемент идет в sum_rare
 
 
 void fill_array(vector<int>& a) {
@@ -80,55 +93,453 @@ void inverted_hint_sum(const vector<int>& a, long long& sum_many, long long& sum
 }
 
 
+// Сумма всех элементов без ветвлений; при наличии AVX2 - явный SIMD с расширением до 64 бит
+static long long total_scalar(const int* p, size_t n) {
+    long long acc[4] = {0, 0, 0, 0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc[0] += p[i];
+        acc[1] += p[i + 1];
+        acc[2] += p[i + 2];
+        acc[3] += p[i + 3];
+    }
+    for (; i < n; ++i) acc[0] += p[i];
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+#ifdef HAVE_X86
+__attribute__((target("avx2")))
+static long long total_avx2(const int* p, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    alignas(32) long long lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + total_scalar(p + i, n - i);
+}
+#endif
+
+static long long total_sum(const int* p, size_t n) {
+#ifdef HAVE_X86
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) return total_avx2(p, n);
+#endif
+    return total_scalar(p, n);
+}
+
+
+// Без % и без ветвления в цикле: редкие элементы собираются отдельным проходом с шагом
+// STRIDE, а частые получаются как разность общей SIMD-суммы и редкой
+void strided_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+    sum_rare = 0;
+    for (size_t i = 0; i < a.size(); i += STRIDE) {
+        sum_rare += a[i];
+    }
+    sum_many = total_sum(a.data(), a.size()) - sum_rare;
+}
+
+
+// Без ветвления: счетчик вместо %, элемент раскладывается по маске
+void branchless_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+    sum_many = 0;
+    sum_rare = 0;
+    size_t phase = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        long long v = a[i];
+        long long mask = -static_cast<long long>(phase == 0);
+        sum_rare += v & mask;
+        sum_many += v & ~mask;
+        phase = (phase + 1 == STRIDE) ? 0 : phase + 1;
+    }
+}
+
+
+// Плитки по STRIDE элементов: первый элемент плитки - редкий, остальные суммируются
+// внутренним циклом без условий, который компилятор может векторизовать
+void blocked_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+    sum_many = 0;
+    sum_rare = 0;
+    const int* p = a.data();
+    for (size_t tile = 0; tile < a.size(); tile += STRIDE) {
+        size_t end = min(tile + STRIDE, a.size());
+        sum_rare += p[tile];
+        long long many = 0;
+        for (size_t i = tile + 1; i < end; ++i) {
+            many += p[i];
+        }
+        sum_many += many;
+    }
+}
+
+
+// key - короткое имя варианта для журнала счетчиков; одна запись "lab10/index/<key>" на все повторы
 template<typename Func>
-double measure_time(Func f, const vector<int>& a, long long& out_many, long long& out_rare) {
+double measure_time(const char* key, Func f, const vector<int>& a, long long& out_many, long long& out_rare) {
     double total = 0.0;
     long long sm = 0, sr = 0;
+    PerfScope perf_scope(string("lab10/index/") + key);
     for (int r = 0; r < REPEATS; ++r) {
         auto start = high_resolution_clock::now();
         f(a, sm, sr);
         auto end = high_resolution_clock::now();
         total += duration<double>(end - start).count();
     }
+    perf_scope.stop();
     out_many = sm;
     out_rare = sr;
     return total / REPEATS;
 }
 
 
-int main() {
+// ---------------------------------------------------------------------------
+// Режим data: условие зависит от значений массива, а не от индекса.
+// Элемент идет в sum_rare, если a[i] < DATA_THRESHOLD. Шаблон массива задает,
+// насколько предсказуемо это ветвление:
+//   random    - каждый элемент независимо, с вероятностью p;
+//   periodic  - случайный узор длины len, повторенный по всему массиву;
+//   sorted    - тот же набор, что и random, но отсортированный (одна смена исхода);
+//   clustered - серии одинаковых исходов, средняя длина серии порядка len.
+// ---------------------------------------------------------------------------
+
+static const int DATA_THRESHOLD = 501;  // [1, 500] - условие истинно, [501, 1000] - ложно
+
+enum class DataPattern { RANDOM, PERIODIC, SORTED, CLUSTERED };
+
+static const char* pattern_name(DataPattern pattern) {
+    switch (pattern) {
+        case DataPattern::RANDOM:    return "random";
+        case DataPattern::PERIODIC:  return "periodic";
+        case DataPattern::SORTED:    return "sorted";
+        case DataPattern::CLUSTERED: return "clustered";
+    }
+    return "?";
+}
+
+void fill_pattern(vector<int>& a, DataPattern pattern, double p, size_t len) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> taken_value(1, DATA_THRESHOLD - 1);
+    std::uniform_int_distribution<int> other_value(DATA_THRESHOLD, 1000);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    auto value = [&](bool taken) { return taken ? taken_value(rng) : other_value(rng); };
+
+    if (pattern == DataPattern::PERIODIC) {
+        vector<bool> period(max<size_t>(len, 1));
+        for (size_t k = 0; k < period.size(); ++k) period[k] = coin(rng) < p;
+        for (size_t i = 0; i < a.size(); ++i) a[i] = value(period[i % period.size()]);
+    } else if (pattern == DataPattern::CLUSTERED) {
+        // Марковская цепь: стационарная доля истинных исходов равна p,
+        // средние длины серий len/(1-p) и len/p
+        double leave_taken = (1.0 - p) / max<size_t>(len, 1);
+        double leave_other = p / max<size_t>(len, 1);
+        bool taken = coin(rng) < p;
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = value(taken);
+            if (coin(rng) < (taken ? leave_taken : leave_other)) taken = !taken;
+        }
+    } else {
+        for (size_t i = 0; i < a.size(); ++i) a[i] = value(coin(rng) < p);
+        if (pattern == DataPattern::SORTED) std::sort(a.begin(), a.end());
+    }
+}
+
+
+void data_branch_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+    sum_many = 0;
+    sum_rare = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] < DATA_THRESHOLD) {
+            sum_rare += a[i];
+        } else {
+            sum_many += a[i];
+        }
+    }
+}
+
+void data_likely_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+    sum_many = 0;
+    sum_rare = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (likely(a[i] < DATA_THRESHOLD)) {
+            sum_rare += a[i];
+        } else {
+            sum_many += a[i];
+        }
+    }
+}
+
+void data_unlikely_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+    sum_many = 0;
+    sum_rare = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (unlikely(a[i] < DATA_THRESHOLD)) {
+            sum_rare += a[i];
+        } else {
+            sum_many += a[i];
+        }
+    }
+}
+
+#if __cplusplus >= 202002L
+void data_attribute_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+    sum_many = 0;
+    sum_rare = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] < DATA_THRESHOLD) [[likely]] {
+            sum_rare += a[i];
+        } else {
+            sum_many += a[i];
+        }
+    }
+}
+#endif
+
+// Условная пересылка вместо перехода: обе суммы обновляются всегда
+void data_cmov_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+    sum_many = 0;
+    sum_rare = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        long long v = a[i];
+        long long rare = v < DATA_THRESHOLD ? v : 0;
+        sum_rare += rare;
+        sum_many += v - rare;
+    }
+}
+
+#ifdef HAVE_X86
+__attribute__((target("avx2")))
+static long long rare_avx2(const int* p, size_t n) {
+    const __m256i threshold = _mm256_set1_epi32(DATA_THRESHOLD);
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i rare = _mm256_and_si256(v, _mm256_cmpgt_epi32(threshold, v));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(rare)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(rare, 1)));
+    }
+    alignas(32) long long lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+    long long sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) sum += p[i] < DATA_THRESHOLD ? p[i] : 0;
+    return sum;
+}
+#endif
+
+// SIMD-маска: редкая сумма через сравнение и AND, частая - как разность с общей суммой
+void data_simd_sum(const vector<int>& a, long long& sum_many, long long& sum_rare) {
+#ifdef HAVE_X86
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) {
+        sum_rare = rare_avx2(a.data(), a.size());
+        sum_many = total_sum(a.data(), a.size()) - sum_rare;
+        return;
+    }
+#endif
+    data_cmov_sum(a, sum_many, sum_rare);
+}
+
+
+// Варианты сплит-суммы: key - короткое имя для режима bench, title - заголовок в консоли
+using Kernel = void (*)(const vector<int>&, long long&, long long&);
+struct Variant {
+    const char* key;
+    const char* title;
+    Kernel kernel;
+};
+
+// Условие по индексу (i % 1000); все ядра обязаны давать те же sum_many/sum_rare, что и baseline
+static const Variant INDEX_VARIANTS[] = {
+    {"baseline", "Baseline (без подсказок)", baseline_sum},
+    {"correct_hint", "Верная подсказка (unlikely(i%1000==0))", correct_hint_sum},
+    {"wrong_hint", "Неверная подсказка (likely(i%1000==0))", wrong_hint_sum},
+    {"inverted_hint", "Инвертированная «перевернутая» подсказка", inverted_hint_sum},
+    {"strided", "Шаговая выборка (SIMD-сумма минус каждый 1000-й)", strided_sum},
+    {"branchless", "Без ветвлений (маска вместо if, счетчик вместо %)", branchless_sum},
+    {"blocked", "Плитки по 1000 элементов", blocked_sum},
+};
+
+// Условие по данным (a[i] < DATA_THRESHOLD)
+static const Variant DATA_VARIANTS[] = {
+    {"branch", "Ветвление без подсказок", data_branch_sum},
+    {"likely", "likely(a[i] < T)", data_likely_sum},
+    {"unlikely", "unlikely(a[i] < T)", data_unlikely_sum},
+#if __cplusplus >= 202002L
+    {"attribute", "Атрибут [[likely]]", data_attribute_sum},
+#endif
+    {"cmov", "Условная пересылка (cmov)", data_cmov_sum},
+    {"simd", "SIMD-маска", data_simd_sum},
+};
+
+struct DataRun {
+    double time = 0.0;
+    long long sum_many = 0, sum_rare = 0;
+    bool counted = false;
+    uint64_t branches = 0, branch_misses = 0;
+};
+
+template<typename Func>
+DataRun measure_counted(Func f, const vector<int>& a) {
+    DataRun run;
+    PerfCounters counters{PerfEvent::BRANCHES, PerfEvent::BRANCH_MISSES};
+    for (int r = 0; r < REPEATS; ++r) {
+        counters.start();
+        auto start = high_resolution_clock::now();
+        f(a, run.sum_many, run.sum_rare);
+        auto end = high_resolution_clock::now();
+        counters.stop();
+        run.time += duration<double>(end - start).count();
+        auto branches = counters.value(PerfEvent::BRANCHES);
+        auto misses = counters.value(PerfEvent::BRANCH_MISSES);
+        if (branches && misses) {
+            run.counted = true;
+            run.branches += *branches;
+            run.branch_misses += *misses;
+        }
+    }
+    run.time /= REPEATS;
+    return run;
+}
+
+// main.exe data [random|periodic|sorted|clustered|all] [p] [n] [len]
+int run_data_mode(int argc, char* argv[]) {
+    string which = argc > 2 ? argv[2] : "all";
+    double p = argc > 3 ? atof(argv[3]) : 0.5;
+    size_t n = argc > 4 ? strtoull(argv[4], nullptr, 10) : 100'000'000;
+    size_t len = argc > 5 ? strtoull(argv[5], nullptr, 10) : 64;
+    if (p < 0.0 || p > 1.0 || n == 0) {
+        cerr << "Использование: " << argv[0] << " data [random|periodic|sorted|clustered|all] [p] [n] [len]\n";
+        return 1;
+    }
+
+    vector<DataPattern> patterns;
+    for (DataPattern pattern : {DataPattern::RANDOM, DataPattern::PERIODIC, DataPattern::SORTED, DataPattern::CLUSTERED}) {
+        if (which == "all" || which == pattern_name(pattern)) patterns.push_back(pattern);
+    }
+    if (patterns.empty()) {
+        cerr << "Неизвестный шаблон: " << which << "\n";
+        return 1;
+    }
+
+
+    cout << "=======================================================\n\n";
+    cout << "Режим data: условие a[i] < " << DATA_THRESHOLD << ", p = " << p
+         << ", размер массива " << n << ", len = " << len << "\n";
+    bool all_match = true;
+    vector<int> data(n);
+    for (DataPattern pattern : patterns) {
+        fill_pattern(data, pattern, p, len);
+        cout << "\n=== Шаблон " << pattern_name(pattern) << " (усреднённое время из " << REPEATS << " запусков) ===\n\n";
+        long long ref_many = 0, ref_rare = 0;
+        int number = 1;
+        for (const Variant& v : DATA_VARIANTS) {
+            DataRun run = measure_counted(v.kernel, data);
+            if (number == 1) {
+                ref_many = run.sum_many;
+                ref_rare = run.sum_rare;
+            }
+            bool match = run.sum_many == ref_many && run.sum_rare == ref_rare;
+            all_match &= match;
+            cout << number++ << ") " << v.title << ":\n";
+            cout << "   Time = " << run.time << " с,  branch-miss = ";
+            if (run.counted && run.branches > 0) {
+                cout << 100.0 * run.branch_misses / run.branches << " % ("
+                     << run.branch_misses / REPEATS << " из " << run.branches / REPEATS << ")";
+            } else {
+                cout << "n/a";
+            }
+            cout << ",  sum_many = " << run.sum_many << ", sum_rare = " << run.sum_rare
+                 << (match ? "" : "  <-- НЕ СОВПАДАЕТ") << "\n\n";
+        }
+    }
+    cout << "=======================================================\n";
+    if (!all_match) {
+        cout << "ОШИБКА: суммы вариантов расходятся\n";
+        return 1;
+    }
+    return 0;
+}
+
+// main.exe bench [опции bench.h]: все варианты через общий микробенчмарк. Ядра по индексу
+// работают на массиве из N элементов, ядра по данным - на BENCH_DATA_N элементах каждого
+// шаблона с p = 0.5 и len = 64.
+static const size_t BENCH_DATA_N = 10'000'000;
+
+int run_bench(int argc, char* argv[]) {
+    vector<int> data(N);
+    fill_array(data);
+    const DataPattern patterns[] = {DataPattern::RANDOM, DataPattern::PERIODIC, DataPattern::SORTED, DataPattern::CLUSTERED};
+    vector<vector<int>> patterned;
+    for (DataPattern pattern : patterns) {
+        patterned.emplace_back(BENCH_DATA_N);
+        fill_pattern(patterned.back(), pattern, 0.5, 64);
+    }
+
+    BenchRegistry registry;
+    auto add = [&registry](string name, const vector<int>& a, Kernel kernel) {
+        registry.add(move(name), [&a, kernel] {
+            long long many = 0, rare = 0;
+            kernel(a, many, rare);
+            do_not_optimize(many);
+            do_not_optimize(rare);
+        });
+    };
+    for (const Variant& v : INDEX_VARIANTS) {
+        add(string("lab10/index/") + v.key, data, v.kernel);
+    }
+    for (size_t k = 0; k < patterned.size(); ++k) {
+        for (const Variant& v : DATA_VARIANTS) {
+            add(string("lab10/data/") + pattern_name(patterns[k]) + "/" + v.key, patterned[k], v.kernel);
+        }
+    }
+    return registry.main(argc, argv);
+}
+
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
     SetConsoleCP(CP_UTF8);
+#endif
     
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
+    if (argc > 1 && strcmp(argv[1], "data") == 0) {
+        return run_data_mode(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        return run_bench(argc, argv);
+    }
     cout << "=======================================================\n\n";
     vector<int> data(N);
     fill_array(data);
     cout << "Размер массива " << N << " элементов\n";
-    long long baseline_many = 0, baseline_rare = 0;
-    long long correct_many  = 0, correct_rare  = 0;
-    long long wrong_many    = 0, wrong_rare    = 0;
-    long long invert_many   = 0, invert_rare   = 0;
 
-    double t_baseline = measure_time(baseline_sum,       data, baseline_many, baseline_rare);
-    double t_correct  = measure_time(correct_hint_sum,  data, correct_many,  correct_rare);
-    double t_wrong    = measure_time(wrong_hint_sum,    data, wrong_many,    wrong_rare);
-    double t_invert   = measure_time(inverted_hint_sum, data, invert_many,   invert_rare);
 
     cout << "=== Результаты (усреднённое время из " << REPEATS << " запусков) ===\n\n";
-    cout << "1) Baseline (без подсказок):\n";
-    cout << "   Time = " << t_baseline << " с,  sum_many = " << baseline_many
-         << ", sum_rare = " << baseline_rare << "\n\n";
-    cout << "2) Верная подсказка (unlikely(i%1000==0)):\n";
-    cout << "   Time = " << t_correct << " с,  sum_many = " << correct_many
-         << ", sum_rare = " << correct_rare << "\n\n";
-    cout << "3) Неверная подсказка (likely(i%1000==0)):\n";
-    cout << "   Time = " << t_wrong << " с,  sum_many = " << wrong_many
-         << ", sum_rare = " << wrong_rare << "\n\n";
-    cout << "4) Инвертированная «перевернутая» подсказка:\n";
-    cout << "   Time = " << t_invert << " с,  sum_many = " << invert_many
-         << ", sum_rare = " << invert_rare << "\n\n";
+    long long ref_many = 0, ref_rare = 0;
+    bool all_match = true;
+    int number = 1;
+    for (const Variant& v : INDEX_VARIANTS) {
+        long long many = 0, rare = 0;
+        double t = measure_time(v.key, v.kernel, data, many, rare);
+        if (number == 1) {
+            ref_many = many;
+            ref_rare = rare;
+        }
+        bool match = many == ref_many && rare == ref_rare;
+        all_match &= match;
+        cout << number++ << ") " << v.title << ":\n";
+        cout << "   Time = " << t << " с,  sum_many = " << many
+             << ", sum_rare = " << rare << (match ? "" : "  <-- НЕ СОВПАДАЕТ С BASELINE") << "\n\n";
+    }
+    if (!all_match) {
+        cout << "ОШИБКА: суммы вариантов расходятся\n";
+        return 1;
+    }
     cout << "=======================================================\n";
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,4 @@
 import subprocess
-import re
 import json
 import matplotlib.pyplot as plt
 import numpy as np
@@ -22,32 +21,37 @@ def compile_program(optimization_level):
     
     return output_name
 
+# Ключ результата -> имя ядра в режиме bench (lab10/index/<key> в main.cpp)
+BENCH_NAMES = {
+    'baseline': 'lab10/index/baseline',
+    'correct': 'lab10/index/correct_hint',
+    'wrong': 'lab10/index/wrong_hint',
+    'invert': 'lab10/index/inverted_hint',
+    'strided': 'lab10/index/strided',
+    'branchless': 'lab10/index/branchless',
+    'blocked': 'lab10/index/blocked',
+}
+
 def run_program(program_name):
-    """Запускает программу и возвращает её вывод"""
+    """Запускает ядра по индексу через общий микробенчмарк; возвращает разобранный JSON"""
     print(f"Запускаем {program_name}...")
-    result = subprocess.run(program_name, shell=True, capture_output=True, text=True, encoding='utf-8')
+    cmd = [os.path.abspath(program_name), 'bench', '--format=json', '--filter=lab10/index/']
+    result = subprocess.run(cmd, capture_output=True, text=True, encoding='utf-8')
     
     if result.returncode != 0:
         print(f"Ошибка запуска {program_name}: {result.stderr}")
         return None
     
-    return result.stdout
+    return json.loads(result.stdout)
 
-def parse_results(output_text):
-    """Парсит результаты из вывода программы"""
+def parse_results(report):
+    """Медиана времени одного повторения для каждого ядра из JSON режима bench"""
+    medians = {b['name']: b['median'] for b in report['benchmarks']}
     results = {}
     
-    patterns = {
-        'baseline': r'1\) Baseline.*?Time = ([\d.]+) с',
-        'correct': r'2\) Верная подсказка.*?Time = ([\d.]+) с',
-        'wrong': r'3\) Неверная подсказка.*?Time = ([\d.]+) с',
-        'invert': r'4\) Инвертированная.*?Time = ([\d.]+) с'
-    }
-    
-    for name, pattern in patterns.items():
-        match = re.search(pattern, output_text, re.DOTALL)
-        if match:
-            results[name] = float(match.group(1))
+    for key, name in BENCH_NAMES.items():
+        if name in medians:
+            results[key] = medians[name]
         else:
             print(f"Не удалось найти результаты для {name}")
     
@@ -56,7 +60,12 @@ def parse_results(output_text):
 def create_charts(all_results):
     """Создает графики сравнения результатов"""
     optimizations = ['O0', 'O1', 'O2', 'O3', 'Os', 'Oz']
-    methods = ['baseline', 'correct', 'wrong', 'invert']
+    methods = ['baseline', 'correct', 'wrong', 'invert', 'strided', 'branchless', 'blocked']
+    labels = {
+        'baseline': 'Baseline', 'correct': 'Correct hint', 'wrong': 'Wrong hint',
+        'invert': 'Inverted hint', 'strided': 'Strided + SIMD', 'branchless': 'Branchless',
+        'blocked': 'Blocked tiles'
+    }
     
     # Подготовка данных
     data = {}
@@ -73,12 +82,11 @@ def create_charts(all_results):
     
     # График 1: Время выполнения
     x = np.arange(len(optimizations))
-    width = 0.2
+    width = 0.8 / len(methods)
     
-    ax1.bar(x - 1.5*width, data['baseline'], width, label='Baseline', alpha=0.8)
-    ax1.bar(x - 0.5*width, data['correct'], width, label='Correct hint', alpha=0.8)
-    ax1.bar(x + 0.5*width, data['wrong'], width, label='Wrong hint', alpha=0.8)
-    ax1.bar(x + 1.5*width, data['invert'], width, label='Inverted hint', alpha=0.8)
+    for k, method in enumerate(methods):
+        offset = (k - (len(methods) - 1) / 2) * width
+        ax1.bar(x + offset, data[method], width, label=labels[method], alpha=0.8)
     
     ax1.set_xlabel('Уровень оптимизации')
     ax1.set_ylabel('Время выполнения (секунды)')
@@ -101,9 +109,10 @@ def create_charts(all_results):
                 else:
                     relative_data[method].append(1.0)
     
-    ax2.bar(x - 0.5*width, relative_data['correct'], width, label='Correct hint', alpha=0.8)
-    ax2.bar(x + 0.5*width, relative_data['wrong'], width, label='Wrong hint', alpha=0.8)
-    ax2.bar(x + 1.5*width, relative_data['invert'], width, label='Inverted hint', alpha=0.8)
+    others = methods[1:]
+    for k, method in enumerate(others):
+        offset = (k - (len(others) - 1) / 2) * width
+        ax2.bar(x + offset, relative_data[method], width, label=labels[method], alpha=0.8)
     
     ax2.set_xlabel('Уровень оптимизации')
     ax2.set_ylabel('Относительная производительность')
@@ -1,10 +1,22 @@
+#include <cctype>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <chrono>
 #include <numeric>
 #include <random>
+#include <sstream>
+#include <thread>
+#ifdef _WIN32
 #include <windows.h>
+#endif
+#ifdef __linux__
+#include "../common/async_reader.h"
+#endif
+#include "../common/bench.h"
+#include "../common/block_reader.h"
+#include "../common/perf_counters.h"
+#include "../common/pointer_chase.h"
 
 constexpr int SEED = 42;
 
@@ -46,67 +58,389 @@ void create_test_file(const std::string& filename, size_t size) {
     file_out.close();
 }
 
-void measure_time(int k, std::ifstream& file_in, std::streamsize file_size) {
-    const int block_size = 8; 
-    const int num_reads = 1000000; 
-    if (file_size < k) {
-        std::cerr << "Размер k превышает размер файла! Пропускаем k = " << k << std::endl;
-        return;
+const size_t TEST_FILE_SIZE = 100 * 1024 * 1024; // 100 MB
+
+// Создает тестовый файл, если его еще нет
+void ensure_test_file(const std::string& filename) {
+    std::ifstream check_file(filename);
+    if (!check_file.good()) {
+        std::cout << "Создаем тестовый файл размером " << TEST_FILE_SIZE << " байт..." << std::endl;
+        create_test_file(filename, TEST_FILE_SIZE);
     }
-    RandomGenerator rng(SEED); 
-    unsigned long a = rng.next() % (file_size - k);
-    std::cout << "Используем фиксированное смещение a = " << a << std::endl;
-    auto start = std::chrono::high_resolution_clock::now();
+}
+
+constexpr int BLOCK_SIZE = 8;
+constexpr int NUM_READS = 1000000;
+const std::vector<int> WINDOWS = {24000, 30000, 48000, 80000, 200000, 500000, 1000000,
+                                  5000000, 8000000, 20000000, 40000000, 80000000};
+
+// NUM_READS чтений по BLOCK_SIZE байт в окне [a, a + k); rng продолжает последовательность после a
+template <typename Reader>
+unsigned long random_reads(Reader& reader, int k, unsigned long a, RandomGenerator rng, std::streamsize file_size) {
     unsigned long sum = 0;
-    for (int i = 0; i < num_reads; ++i) {
+    for (int i = 0; i < NUM_READS; ++i) {
         unsigned long offset = a + (rng.next() % k);
-        if (offset + block_size > file_size) {
+        if (offset + BLOCK_SIZE > file_size) {
             continue;
         }
-        file_in.seekg(offset, std::ios::beg);
-        char buffer[block_size];
-        file_in.read(buffer, block_size);
-        for (int j = 0; j < block_size; ++j) {
-            sum += static_cast<unsigned char>(buffer[j]); 
+        char buffer[BLOCK_SIZE];
+        reader.read(offset, buffer, BLOCK_SIZE);
+        for (int j = 0; j < BLOCK_SIZE; ++j) {
+            sum += static_cast<unsigned char>(buffer[j]);
         }
     }
+    return sum;
+}
+
+// Возвращает контрольную сумму; для пропущенного k - nullopt
+std::optional<unsigned long> measure_time(int k, ReadBackend backend, BlockReader& reader, std::streamsize file_size) {
+    if (file_size < k) {
+        std::cerr << "Размер k превышает размер файла! Пропускаем k = " << k << std::endl;
+        return std::nullopt;
+    }
+    RandomGenerator rng(SEED); 
+    unsigned long a = rng.next() % (file_size - k);
+    std::cout << "Используем фиксированное смещение a = " << a << std::endl;
+    PerfScope perf_scope(std::string("lab2/") + read_backend_name(backend) + "/k=" + std::to_string(k));
+    auto start = std::chrono::high_resolution_clock::now();
+    unsigned long sum = std::visit([&](auto& r) { return random_reads(r, k, a, rng, file_size); }, reader);
     auto end = std::chrono::high_resolution_clock::now();
+    perf_scope.stop();
     std::chrono::duration<double> duration = end - start;
     std::cout << "Time for k = " << k << ": " << duration.count() << " seconds, checksum = " << sum << std::endl;
+    return sum;
 }
 
-int main() {
+// Все окна для каждого способа чтения: lab2/<способ>/k=<k>
+int run_bench(int argc, char* argv[], const std::string& filename, std::streamsize file_size) {
+    std::vector<BlockReader> readers;
+    for (ReadBackend backend : available_read_backends()) {
+        try {
+            readers.push_back(open_block_reader(backend, filename));
+        } catch (const std::exception& e) {
+            std::cerr << "Не удалось открыть " << filename << " способом " << read_backend_name(backend) << ": "
+                      << e.what() << std::endl;
+            return 1;
+        }
+    }
+    BenchRegistry registry;
+    for (size_t b = 0; b < readers.size(); ++b) {
+        for (int k : WINDOWS) {
+            if (file_size < k) continue;
+            std::string name = std::string("lab2/") + read_backend_name(available_read_backends()[b]) + "/k=" + std::to_string(k);
+            registry.add(name, [&readers, b, k, file_size] {
+                RandomGenerator rng(SEED);
+                unsigned long a = rng.next() % (file_size - k);
+                do_not_optimize(std::visit([&](auto& r) { return random_reads(r, k, a, rng, file_size); }, readers[b]));
+            });
+        }
+    }
+    return registry.main(argc, argv);
+}
+
+constexpr size_t CHASE_STEPS = size_t(1) << 22;
+
+void print_boundaries(const std::vector<LatencyBoundary>& boundaries, const char* unit,
+                      const std::vector<std::string>& names) {
+    for (size_t i = 0; i < boundaries.size(); ++i) {
+        const LatencyBoundary& b = boundaries[i];
+        std::cout << "  " << names[i] << ": до " << b.size << unit << ", " << b.before_ns << " нс -> "
+                  << b.after_ns << " нс" << std::endl;
+    }
+    if (boundaries.empty()) std::cout << "  скачков не найдено" << std::endl;
+}
+
+// main.exe chase [4k|thp|2m|1g] [мин. окно, КБ] [макс. окно, МБ]:
+// задержка зависимых чтений по случайному циклу внутри окна и границы иерархии памяти
+int run_chase_mode(int argc, char* argv[]) {
+    std::optional<ChasePages> pages = parse_chase_pages(argc > 2 ? argv[2] : "4k");
+    size_t min_bytes = (argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4) << 10;
+    size_t max_bytes = (argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 256) << 20;
+    if (!pages || min_bytes == 0 || min_bytes > max_bytes) {
+        std::cerr << "Использование: " << argv[0] << " chase [4k|thp|2m|1g] [мин. КБ] [макс. МБ]" << std::endl;
+        return 1;
+    }
+    std::optional<ChaseBuffer> buffer;
+    try {
+        buffer.emplace(max_bytes, *pages);
+    } catch (const std::bad_alloc&) {
+        std::cerr << "Не удалось выделить " << (max_bytes >> 20) << " МБ страницами " << chase_pages_name(*pages)
+                  << std::endl;
+        return 1;
+    }
+    std::string prefix = std::string("lab2/chase/") + chase_pages_name(*pages);
+
+    std::cout << "Страницы: " << chase_pages_name(*pages) << std::endl;
+    std::cout << "Окно, байт\tнс/переход" << std::endl;
+    std::vector<LatencyPoint> lines;
+    for (size_t size : log_sweep(min_bytes, max_bytes, 4, CHASE_LINE)) {
+        void** start = build_line_cycle(buffer->data(), size, SEED);
+        PerfScope perf_scope(prefix + "/size=" + std::to_string(size));
+        double ns = chase_latency_ns(start, size / CHASE_LINE, CHASE_STEPS);
+        perf_scope.stop();
+        lines.push_back({size, ns});
+        std::cout << size << "\t" << ns << std::endl;
+    }
+
+    // Одна строка на страницу 4 КБ: объем данных мал, растет число страниц - видны промахи TLB
+    std::cout << "Страниц 4 КБ\tнс/переход" << std::endl;
+    std::vector<LatencyPoint> tlb;
+    for (size_t count : log_sweep(8, std::min<size_t>(buffer->size() / CHASE_PAGE, 65536), 4, 1)) {
+        void** start = build_page_cycle(buffer->data(), count, SEED);
+        PerfScope perf_scope(prefix + "/pages=" + std::to_string(count));
+        double ns = chase_latency_ns(start, count, CHASE_STEPS);
+        perf_scope.stop();
+        tlb.push_back({count, ns});
+        std::cout << count << "\t" << ns << std::endl;
+    }
+
+    std::vector<CacheLevel> levels = detect_cache_levels();
+    std::cout << "Кэши по sysfs:";
+    for (const CacheLevel& level : levels) std::cout << " " << level.name << " = " << (level.bytes >> 10) << " КБ";
+    std::cout << std::endl;
+
+    std::vector<LatencyBoundary> line_bounds = detect_boundaries(lines);
+    std::vector<std::string> line_names;
+    for (const LatencyBoundary& b : line_bounds) line_names.push_back(name_boundary(b.size, levels));
+    std::cout << "Границы по размеру окна:" << std::endl;
+    print_boundaries(line_bounds, " байт", line_names);
+
+    // Первый скачок по числу страниц - L1 DTLB, второй - общий STLB; с огромными страницами их нет
+    std::vector<LatencyBoundary> tlb_bounds = detect_boundaries(tlb);
+    std::vector<std::string> tlb_names;
+    for (size_t i = 0; i < tlb_bounds.size(); ++i) tlb_names.push_back(i == 0 ? "DTLB" : i == 1 ? "STLB" : "?");
+    std::cout << "Границы по числу страниц:" << std::endl;
+    print_boundaries(tlb_bounds, " страниц", tlb_names);
+    return 0;
+}
+
+// main.exe bandwidth [макс. потоков] [макс. цепочек] [макс. окно на поток, МБ] [4k|thp|2m|1g]:
+// потоки со своими окнами и потоками RandomGenerator, в каждом по нескольку независимых
+// цепочек переходов; суммарные доступы/с и ГБ/с против числа потоков, цепочек и размера окна
+int run_bandwidth_mode(int argc, char* argv[]) {
+    size_t max_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+    size_t max_chains = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : CHASE_MAX_CHAINS;
+    size_t max_bytes = (argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 64) << 20;
+    std::optional<ChasePages> pages = parse_chase_pages(argc > 5 ? argv[5] : "4k");
+    if (!pages || max_threads == 0 || max_chains == 0 || max_chains > CHASE_MAX_CHAINS || max_bytes == 0) {
+        std::cerr << "Использование: " << argv[0] << " bandwidth [макс. потоков] [макс. цепочек 1.." << CHASE_MAX_CHAINS
+                  << "] [макс. МБ на поток] [4k|thp|2m|1g]" << std::endl;
+        return 1;
+    }
+    auto doubling = [](size_t max) {
+        std::vector<size_t> values;
+        for (size_t v = 1; v < max; v *= 2) values.push_back(v);
+        values.push_back(max);
+        return values;
+    };
+
+    std::cout << "Потоков\tЦепочек\tОкно на поток, байт\tМлн доступов/с\tГБ/с\tнс/переход в цепочке" << std::endl;
+    for (size_t threads : doubling(max_threads)) {
+        std::vector<uint64_t> seeds;
+        for (size_t t = 0; t < threads; ++t) {
+            RandomGenerator rng(SEED + t);
+            seeds.push_back(rng.next());
+        }
+        for (size_t size : log_sweep(std::min<size_t>(256 << 10, max_bytes), max_bytes, 1, CHASE_LINE)) {
+            for (size_t chains : doubling(max_chains)) {
+                size_t steps = std::max<size_t>(CHASE_STEPS / chains, 1 << 12);
+                ParallelChaseResult result;
+                try {
+                    PerfScope perf_scope("lab2/bandwidth/threads=" + std::to_string(threads) + "/chains=" +
+                                         std::to_string(chains) + "/size=" + std::to_string(size));
+                    perf_scope.set_threads(static_cast<unsigned>(threads));
+                    result = parallel_chase(threads, chains, size, *pages, seeds, steps);
+                } catch (const std::bad_alloc&) {
+                    std::cerr << "Не удалось выделить " << threads << " x " << size << " байт страницами "
+                              << chase_pages_name(*pages) << std::endl;
+                    return 1;
+                }
+                std::cout << threads << "\t" << chains << "\t" << size << "\t" << result.per_second() / 1e6 << "\t"
+                          << result.gbytes_per_second() << "\t" << result.seconds * 1e9 / steps << std::endl;
+            }
+        }
+    }
+    return 0;
+}
+
+#ifdef __linux__
+// main.exe async [--engine=auto|uring|pool] [--qd=1,2,4,...] [--block=4096] [--reads=N]
+//                [--direct] [--registered] [--file=ПУТЬ]:
+// выровненные случайные чтения блоков по всему файлу с глубиной очереди QD; IOPS и процентили задержки
+int run_async_mode(int argc, char* argv[], const std::string& default_file) {
+    AsyncEngine engine = AsyncEngine::AUTO;
+    AsyncReadOptions opts;
+    std::vector<size_t> depths = {1, 2, 4, 8, 16, 32, 64};
+    size_t num_reads = 100000;
+    std::string path = default_file;
+    auto usage = [&] {
+        std::cerr << "Использование: " << argv[0] << " async [--engine=auto|uring|pool] [--qd=1,2,4] [--block=4096]"
+                  << " [--reads=N] [--direct] [--registered] [--file=ПУТЬ]" << std::endl;
+        return 1;
+    };
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const std::string& key) -> const char* {
+            return arg.compare(0, key.size(), key) == 0 ? arg.c_str() + key.size() : nullptr;
+        };
+        if (const char* v = value("--engine=")) {
+            std::optional<AsyncEngine> parsed = parse_async_engine(v);
+            if (!parsed) {
+                std::cerr << "Неизвестный движок: " << v << std::endl;
+                return 1;
+            }
+            engine = *parsed;
+        } else if (const char* v = value("--qd=")) {
+            depths.clear();
+            std::stringstream ss(v);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                char* end = nullptr;
+                size_t depth = std::strtoull(item.c_str(), &end, 10);
+                if (item.empty() || !std::isdigit(static_cast<unsigned char>(item[0])) || *end != '\0') {
+                    return usage();
+                }
+                depths.push_back(std::max<size_t>(1, depth));
+            }
+            if (depths.empty()) return usage();
+        } else if (const char* v = value("--block=")) {
+            opts.block = std::strtoull(v, nullptr, 10);
+        } else if (const char* v = value("--reads=")) {
+            num_reads = std::strtoull(v, nullptr, 10);
+        } else if (const char* v = value("--file=")) {
+            path = v;
+        } else if (arg == "--direct") {
+            opts.direct = true;
+        } else if (arg == "--registered") {
+            opts.registered = true;
+        } else {
+            return usage();
+        }
+    }
+    if (path == default_file) ensure_test_file(path);
+    if (opts.block == 0 || (opts.direct && opts.block % ASYNC_ALIGN != 0)) {
+        std::cerr << "С --direct блок должен быть кратен " << ASYNC_ALIGN << " байт" << std::endl;
+        return 1;
+    }
+    std::ifstream file_in(path, std::ios::binary | std::ios::ate);
+    if (!file_in) {
+        std::cerr << "Ошибка при открытии файла " << path << std::endl;
+        return 1;
+    }
+    uint64_t blocks = static_cast<uint64_t>(file_in.tellg()) / opts.block;
+    if (blocks == 0) {
+        std::cerr << "Файл меньше одного блока" << std::endl;
+        return 1;
+    }
+
+    // Смещения одни и те же для всех QD, поэтому и контрольные суммы должны совпасть
+    RandomGenerator rng(SEED);
+    std::vector<uint64_t> offsets(num_reads);
+    for (uint64_t& offset : offsets) offset = rng.next() % blocks * opts.block;
+
+    std::cout << "Файл: " << path << ", блок " << opts.block << " байт, чтений " << num_reads
+              << (opts.direct ? ", O_DIRECT" : "") << (opts.registered ? ", зарегистрированные буферы" : "") << std::endl;
+    std::cout << "QD\tДвижок\tIOPS\tp50, мкс\tp95, мкс\tp99, мкс\tp99.9, мкс\tmax, мкс\tchecksum" << std::endl;
+    std::optional<uint64_t> reference;
+    for (size_t depth : depths) {
+        opts.queue_depth = depth;
+        AsyncReadResult result;
+        try {
+            PerfScope perf_scope("lab2/async/qd=" + std::to_string(depth));
+            result = run_async_reads(engine, path, offsets, opts);
+            // Пул pread читает в depth потоках, io_uring - из вызывающего
+            if (result.engine == AsyncEngine::POOL) perf_scope.set_threads(static_cast<unsigned>(depth));
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка чтения при QD = " << depth << ": " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << depth << "\t" << async_engine_name(result.engine) << "\t" << result.iops() << "\t"
+                  << result.latency_us(0.5) << "\t" << result.latency_us(0.95) << "\t" << result.latency_us(0.99)
+                  << "\t" << result.latency_us(0.999) << "\t" << result.latency_us(1.0) << "\t" << result.checksum
+                  << std::endl;
+        if (reference && *reference != result.checksum) {
+            std::cerr << "Контрольная сумма при QD = " << depth << " не совпадает" << std::endl;
+            return 1;
+        }
+        reference = result.checksum;
+    }
+    return 0;
+}
+#endif
+
+int main(int argc, char* argv[]) {
     // Установка кодировки консоли для Windows
+#ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
     SetConsoleCP(CP_UTF8);
+#endif
     
+    if (argc > 1 && std::string(argv[1]) == "chase") {
+        return run_chase_mode(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "bandwidth") {
+        return run_bandwidth_mode(argc, argv);
+    }
+
     const std::string filename = "test_file.bin";
-    const size_t file_size = 100 * 1024 * 1024; // 100 MB
-    
-    // Create test file if it doesn't exist
-    std::ifstream check_file(filename);
-    if (!check_file.good()) {
-        std::cout << "Создаем тестовый файл размером " << file_size << " байт..." << std::endl;
-        create_test_file(filename, file_size);
+    // async с --file= читает свой файл; тестовый создается, только если путь не задан
+    if (argc > 1 && std::string(argv[1]) == "async") {
+#ifdef __linux__
+        return run_async_mode(argc, argv, filename);
+#else
+        std::cerr << "Режим async есть только в Linux" << std::endl;
+        return 1;
+#endif
     }
-    check_file.close();
-    
+    ensure_test_file(filename);
+
     std::ifstream file_in(filename, std::ios::binary | std::ios::ate);
     if (!file_in) {
         std::cerr << "Ошибка при открытии файла!" << std::endl;
         return 1;
     }
-    
     std::streamsize actual_file_size = file_in.tellg();
-    file_in.seekg(0, std::ios::beg);
+    file_in.close();
+
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        return run_bench(argc, argv, filename, actual_file_size);
+    }
+
+    // main.exe [ifstream|pread|mmap|all]; по умолчанию - ifstream, как раньше
+    std::string which = argc > 1 ? argv[1] : "ifstream";
+    std::vector<ReadBackend> backends;
+    if (which == "all") {
+        backends = available_read_backends();
+    } else if (auto backend = parse_read_backend(which)) {
+        backends.push_back(*backend);
+    } else {
+        std::cerr << "Использование: " << argv[0] << " [ifstream|pread|mmap|all] | chase [...] | bandwidth [...] | async [...] | bench [опции]" << std::endl;
+        return 1;
+    }
     std::cout << "Размер файла: " << actual_file_size << " байт" << std::endl;
-    
-    std::vector<int> ks = {24000, 30000, 48000, 80000, 200000, 500000, 1000000, 
-                           5000000, 8000000, 20000000, 40000000, 80000000}; 
-    for (int k : ks) {
-        measure_time(k, file_in, actual_file_size);
+
+    std::vector<std::optional<unsigned long>> reference;
+    bool all_match = true;
+    for (ReadBackend backend : backends) {
+        std::cout << "Способ чтения: " << read_backend_name(backend) << std::endl;
+        std::optional<BlockReader> reader;
+        try {
+            reader.emplace(open_block_reader(backend, filename));
+        } catch (const std::exception& e) {
+            std::cerr << "Не удалось открыть " << filename << " способом " << read_backend_name(backend) << ": "
+                      << e.what() << std::endl;
+            return 1;
+        }
+        for (size_t i = 0; i < WINDOWS.size(); ++i) {
+            std::optional<unsigned long> sum = measure_time(WINDOWS[i], backend, *reader, actual_file_size);
+            if (reference.size() <= i) {
+                reference.push_back(sum);
+            } else if (sum != reference[i]) {
+                std::cerr << "Контрольная сумма " << read_backend_name(backend) << " для k = " << WINDOWS[i]
+                          << " не совпадает с " << read_backend_name(backends[0]) << std::endl;
+                all_match = false;
+            }
+        }
     }
-    
-    file_in.close();
-    return 0;
-}
\ No newline at end of file
+    return all_match ? 0 : 1;
+}
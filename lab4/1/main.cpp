@@ -1,92 +1,252 @@
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <random>
 #include <chrono>
 #include <string>
 #include <sqlite3.h>
 #include <cstring>
+#include <thread>
+#include <vector>
+#include "../../common/bench.h"
+#include "../../common/perf_counters.h"
+#include "../../common/record_scanner.h"
+#include "../../common/substring_search.h"
 
 using namespace std;
 
-// Функция для чтения строк из файла, которые содержат подстроку
-void read_from_file_with_substring(const string& filename, int total_lines, const string& substring) {
+// Число строк файла, которые содержат подстроку (чтение через iostream); -1 - файл не открылся
+int count_file_ifstream(const string& filename, int total_lines, const string& substring) {
     ifstream file_in(filename, ios::in);  // Открытие файла для чтения
     if (!file_in) {
         cerr << "Ошибка при открытии файла!" << endl;
-        return;
+        return -1;
     }
 
+    SubstringSearcher searcher(substring);
     string str;
     int length;
-    auto start = chrono::high_resolution_clock::now();
-
     int found_count = 0;
     for (int i = 0; i < total_lines; ++i) {
         file_in >> length; // Считываем длину
         file_in >> ws;  // Пропускаем возможные пробелы
         getline(file_in, str); // Считываем строку
 
-        if (strstr(str.c_str(), substring.c_str())) {
+        if (searcher.contains(str)) {
             ++found_count; // Если строка содержит подстроку, увеличиваем счетчик
         }
     }
+    file_in.close();
+    return found_count;
+}
 
-    auto end = chrono::high_resolution_clock::now();
-    chrono::duration<double> duration = end - start;
-    cout << "Время чтения строк с подстрокой из обычного файла: " << duration.count() << " секунд." << endl;
-    cout << "Найдено строк с подстрокой: " << found_count << endl;
+// То же по файлу, отображенному в память: строки - string_view в отображение, без копирования
+int count_file_mmap(const string& filename, int total_lines, const string& substring) {
+    try {
+        RecordFile file(filename);
+        SubstringSearcher searcher(substring);
+        int found_count = 0;
+        file.for_each(total_lines, [&](string_view str) {
+            if (searcher.contains(str)) {
+                ++found_count;
+            }
+        });
+        return found_count;
+    } catch (const runtime_error& e) {
+        cerr << "Ошибка при открытии файла: " << e.what() << endl;
+        return -1;
+    }
+}
 
-    file_in.close();
+// Записи из [pos, end) (не больше limit), которые содержат образец. Поиск идет по всему буферу
+// сразу, а не по строкам: записи до следующего вхождения пропускаются по префиксу длины.
+// Вхождение в префиксе или через перевод строки не засчитывается - поиск продолжается со строки.
+ScanCount count_matching_records(const char* pos, const char* end, size_t limit, const SubstringSearcher& searcher) {
+    ScanCount result;
+    const char* start = pos;
+    const char* hit = searcher.find(pos, end);
+    string_view str;
+    while (pos < end && result.records < limit) {
+        pos = parse_record(pos, end, str);
+        ++result.records;
+        const char* str_begin = str.data();
+        const char* str_end = str_begin + str.size();
+        if (hit < str_begin) hit = searcher.find(str_begin, end);
+        if (hit < str_end || (searcher.size() == 0 && hit == str_end)) {
+            if (hit + searcher.size() <= str_end) ++result.matches;
+            hit = searcher.find(str_end, end);
+        }
+    }
+    result.bytes = static_cast<size_t>(pos - start);
+    return result;
 }
 
-// Функция для чтения строк из SQLite3, которые содержат подстроку
-void read_from_sqlite_with_substring(const string& db_name, int total_lines, const string& substring) {
+int count_file_mmap_buffer(const string& filename, int total_lines, const string& substring) {
+    try {
+        RecordFile file(filename);
+        SubstringSearcher searcher(substring);
+        return static_cast<int>(count_matching_records(file.begin(), file.end(), total_lines, searcher).matches);
+    } catch (const runtime_error& e) {
+        cerr << "Ошибка при открытии файла: " << e.what() << endl;
+        return -1;
+    }
+}
+
+// Поиск по всему буферу кусками в пуле потоков; кусков в 8 раз больше, чем потоков, но не меньше 1 МБ
+ScanCount count_file_parallel(const RecordFile& file, ThreadPool& pool, int total_lines, const SubstringSearcher& searcher) {
+    size_t chunk_bytes = max<size_t>(1 << 20, file.size() / (pool.size() * 8));
+    return parallel_scan_records(pool, file.begin(), file.end(), total_lines, chunk_bytes,
+                                 [&searcher](const char* lo, const char* hi, size_t limit) {
+                                     return count_matching_records(lo, hi, limit, searcher);
+                                 });
+}
+
+// Число строк SQLite3, которые содержат подстроку
+int count_sqlite(const string& db_name, int total_lines, const string& substring) {
     sqlite3* db;
     sqlite3_stmt* stmt;
-    char* err_msg = nullptr;
 
     if (sqlite3_open(db_name.c_str(), &db)) {
         cerr << "Ошибка открытия базы данных: " << sqlite3_errmsg(db) << endl;
-        return;
+        return -1;
     }
 
-    string query = "SELECT length, data FROM strings WHERE data LIKE '%" + substring + "%' LIMIT ?";
-    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    // instr, в отличие от LIKE, учитывает регистр, поэтому вторая проверка строки не нужна
+    const char* query = "SELECT length, data FROM strings WHERE instr(data, ?) > 0 LIMIT ?";
+    if (sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) != SQLITE_OK) {
         cerr << "Ошибка при подготовке запроса: " << sqlite3_errmsg(db) << endl;
         sqlite3_close(db);
-        return;
+        return -1;
     }
 
-    sqlite3_bind_int(stmt, 1, total_lines);  // Ограничиваем количество строк
-
-    auto start = chrono::high_resolution_clock::now();
+    sqlite3_bind_text(stmt, 1, substring.c_str(), static_cast<int>(substring.size()), SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, total_lines);  // Ограничиваем количество строк
 
     int found_count = 0;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const char* data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        if (strstr(data, substring.c_str())) {
-            ++found_count; // Если строка содержит подстроку, увеличиваем счетчик
-        }
+        ++found_count;
     }
 
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return found_count;
+}
+
+template <typename F>
+void measure(const string& source, const string& perf_name, F count) {
+    PerfScope perf_scope(perf_name);
+    auto start = chrono::high_resolution_clock::now();
+    int found_count = count();
     auto end = chrono::high_resolution_clock::now();
+    perf_scope.stop();
+    if (found_count < 0) return;
     chrono::duration<double> duration = end - start;
-    cout << "Время чтения строк с подстрокой из SQLite3: " << duration.count() << " секунд." << endl;
+    cout << "Время чтения строк с подстрокой из " << source << ": " << duration.count() << " секунд." << endl;
     cout << "Найдено строк с подстрокой: " << found_count << endl;
+}
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+// Функция для чтения строк из файла, которые содержат подстроку
+void read_from_file_with_substring(const string& filename, int total_lines, const string& substring) {
+    measure("обычного файла", "lab4/substring/file",
+            [&] { return count_file_ifstream(filename, total_lines, substring); });
+}
+
+void read_from_file_mmap_with_substring(const string& filename, int total_lines, const string& substring) {
+    measure("файла через mmap", "lab4/substring/file/mmap",
+            [&] { return count_file_mmap(filename, total_lines, substring); });
+}
+
+void read_from_file_buffer_with_substring(const string& filename, int total_lines, const string& substring) {
+    measure("файла через mmap (поиск по всему буферу)", "lab4/substring/file/buffer",
+            [&] { return count_file_mmap_buffer(filename, total_lines, substring); });
+}
+
+// Функция для чтения строк из SQLite3, которые содержат подстроку
+void read_from_sqlite_with_substring(const string& db_name, int total_lines, const string& substring) {
+    measure("SQLite3", "lab4/substring/sqlite", [&] { return count_sqlite(db_name, total_lines, substring); });
+}
+
+// main.exe parallel [макс. потоков]: поиск по отображенному файлу в 1, 2, 4, ... потоках
+int run_parallel_mode(int argc, char* argv[], const string& filename, int total_lines, const string& substring) {
+    unsigned max_threads = argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : max(1u, thread::hardware_concurrency());
+    if (max_threads == 0) {
+        cerr << "Использование: " << argv[0] << " parallel [макс. потоков]" << endl;
+        return 1;
+    }
+    try {
+        RecordFile file(filename);
+        SubstringSearcher searcher(substring);
+        ScanCount reference;
+        for (unsigned threads = 1; ; threads = min(threads * 2, max_threads)) {
+            ThreadPool pool(threads);
+            PerfScope perf_scope("lab4/substring/file/parallel/threads=" + to_string(threads));
+            perf_scope.set_threads(threads);
+            auto start = chrono::high_resolution_clock::now();
+            ScanCount result = count_file_parallel(file, pool, total_lines, searcher);
+            auto end = chrono::high_resolution_clock::now();
+            perf_scope.stop();
+            chrono::duration<double> duration = end - start;
+            cout << "Потоков: " << threads << ", время: " << duration.count() << " секунд, "
+                 << result.bytes / duration.count() / 1e9 << " ГБ/с, строк: " << result.records
+                 << ", найдено строк с подстрокой: " << result.matches << endl;
+            if (threads == 1) {
+                reference = result;
+            } else if (result.records != reference.records || result.matches != reference.matches) {
+                cerr << "Результат в " << threads << " потоках не совпадает с однопоточным" << endl;
+                return 1;
+            }
+            if (threads == max_threads) break;
+        }
+    } catch (const runtime_error& e) {
+        cerr << "Ошибка при открытии файла: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
 }
 
-int main(){
+int main(int argc, char* argv[]){
     int total_lines = 3000000; 
     string substring = "ab";
-    read_from_file_with_substring("../write-on-file/data.txt", total_lines, substring);
+    const string filename = "../write-on-file/data.txt";
+    const string db_name = "../write-on-database/database.db";
+    if (argc > 1 && string(argv[1]) == "bench") {
+        BenchRegistry registry;
+        registry.add("lab4/substring/file/ifstream",
+                     [&] { do_not_optimize(count_file_ifstream(filename, total_lines, substring)); });
+        registry.add("lab4/substring/file/mmap",
+                     [&] { do_not_optimize(count_file_mmap(filename, total_lines, substring)); });
+        registry.add("lab4/substring/file/buffer",
+                     [&] { do_not_optimize(count_file_mmap_buffer(filename, total_lines, substring)); });
+        registry.add("lab4/substring/sqlite", [&] { do_not_optimize(count_sqlite(db_name, total_lines, substring)); });
+        unique_ptr<RecordFile> file;
+        vector<unique_ptr<ThreadPool>> pools;
+        SubstringSearcher searcher(substring);
+        try {
+            file = make_unique<RecordFile>(filename);
+        } catch (const runtime_error& e) {
+            cerr << "Ошибка при открытии файла: " << e.what() << endl;
+        }
+        for (unsigned threads = 1; file && threads <= max(1u, thread::hardware_concurrency()); threads *= 2) {
+            ThreadPool* pool = pools.emplace_back(make_unique<ThreadPool>(threads)).get();
+            registry.add("lab4/substring/file/parallel/threads=" + to_string(threads), [&, pool] {
+                do_not_optimize(count_file_parallel(*file, *pool, total_lines, searcher).matches);
+            }, threads);
+        }
+        return registry.main(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "parallel") {
+        return run_parallel_mode(argc, argv, filename, total_lines, substring);
+    }
+    read_from_file_with_substring(filename, total_lines, substring);
 
-    read_from_sqlite_with_substring("../write-on-database/database.db", total_lines, substring);
+    read_from_sqlite_with_substring(db_name, total_lines, substring);
 
-    read_from_sqlite_with_substring("../write-on-database/database.db", total_lines, substring);
+    read_from_sqlite_with_substring(db_name, total_lines, substring);
 
-    read_from_file_with_substring("../write-on-file/data.txt", total_lines, substring);
+    read_from_file_with_substring(filename, total_lines, substring);
+
+    read_from_file_mmap_with_substring(filename, total_lines, substring);
+
+    read_from_file_buffer_with_substring(filename, total_lines, substring);
     return 0;
-}
\ No newline at end of file
+}
@@ -4,19 +4,25 @@
 #include <chrono>
 #include <cstring>
 #include <string>
+#include <memory>
 #include <random>
+#include <thread>
+#include <vector>
+#include "../../common/bench.h"
+#include "../../common/perf_counters.h"
+#include "../../common/record_scanner.h"
 
 using namespace std;
 
-void read_from_file(const string& filename, int total_lines) {
+// Чтение через iostream: длина, пробелы, строка; -1 - файл не открылся
+int count_file_ifstream(const string& filename, int total_lines) {
     ifstream file(filename, ios::in);
     if (!file) {
         cerr << "Ошибка открытия файла!" << endl;
-        return;
+        return -1;
     }
     string str;
     int count = 0;
-    auto start = chrono::high_resolution_clock::now();
     for (int i = 0; i < total_lines; ++i) {
         int length;
         file >> length; 
@@ -24,46 +30,157 @@ void read_from_file(const string& filename, int total_lines) {
         getline(file, str); 
         count++;
     }
-    auto end = chrono::high_resolution_clock::now();
-    chrono::duration<double> duration = end - start;
-    cout << "Время чтения строк из обычного файла: " << duration.count() << " секунд." << endl;
-    cout << "Прочитано строк: " << count << endl;
     file.close();
+    return count;
 }
 
-void read_from_sqlite(const string& db_name, int total_lines) {
+// Записи, начинающиеся в [pos, end), не больше limit; каждая строка - string_view в отображение
+ScanCount count_records(const char* pos, const char* end, size_t limit) {
+    ScanCount result;
+    const char* start = pos;
+    string_view str;
+    while (pos < end && result.records < limit) {
+        pos = parse_record(pos, end, str);
+        do_not_optimize(str);
+        ++result.records;
+    }
+    result.matches = result.records;
+    result.bytes = static_cast<size_t>(pos - start);
+    return result;
+}
+
+// Файл отображается в память, записи идут по префиксу длины без копирования строк
+int count_file_mmap(const string& filename, int total_lines) {
+    try {
+        RecordFile file(filename);
+        return static_cast<int>(count_records(file.begin(), file.end(), total_lines).records);
+    } catch (const runtime_error& e) {
+        cerr << "Ошибка открытия файла: " << e.what() << endl;
+        return -1;
+    }
+}
+
+// То же по кускам файла в пуле потоков; кусков в 8 раз больше, чем потоков, но не меньше 1 МБ
+ScanCount count_file_parallel(const RecordFile& file, ThreadPool& pool, int total_lines) {
+    size_t chunk_bytes = max<size_t>(1 << 20, file.size() / (pool.size() * 8));
+    return parallel_scan_records(pool, file.begin(), file.end(), total_lines, chunk_bytes, count_records);
+}
+
+int count_sqlite(const string& db_name, int total_lines) {
     sqlite3* db;
-    char* err_msg = nullptr;
     if (sqlite3_open(db_name.c_str(), &db)) {
         cerr << "Ошибка открытия базы данных: " << sqlite3_errmsg(db) << endl;
-        return;
+        return -1;
     }
     const char* select_sql = "SELECT data FROM strings;";
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, select_sql, -1, &stmt, nullptr) != SQLITE_OK) {
         cerr << "Ошибка при подготовке запроса: " << sqlite3_errmsg(db) << endl;
         sqlite3_close(db);
-        return;
+        return -1;
     }
-    auto start = chrono::high_resolution_clock::now();
     int count = 0;
     while (sqlite3_step(stmt) == SQLITE_ROW && count < total_lines) {
         const char* str = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        do_not_optimize(str);
         count++;
     }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return count;
+}
+
+template <typename F>
+void measure(const string& source, const string& perf_name, F read) {
+    PerfScope perf_scope(perf_name);
+    auto start = chrono::high_resolution_clock::now();
+    int count = read();
     auto end = chrono::high_resolution_clock::now();
+    perf_scope.stop();
+    if (count < 0) return;
     chrono::duration<double> duration = end - start;
-    cout << "Время чтения строк из SQLite3: " << duration.count() << " секунд." << endl;
+    cout << "Время чтения строк из " << source << ": " << duration.count() << " секунд." << endl;
     cout << "Прочитано строк: " << count << endl;
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
 }
 
-int main() {
+void read_from_file(const string& filename, int total_lines) {
+    measure("обычного файла", "lab4/read/file", [&] { return count_file_ifstream(filename, total_lines); });
+}
+
+void read_from_file_mmap(const string& filename, int total_lines) {
+    measure("файла через mmap", "lab4/read/file/mmap", [&] { return count_file_mmap(filename, total_lines); });
+}
+
+void read_from_sqlite(const string& db_name, int total_lines) {
+    measure("SQLite3", "lab4/read/sqlite", [&] { return count_sqlite(db_name, total_lines); });
+}
+
+// main.exe parallel [макс. потоков]: разбор отображенного файла в 1, 2, 4, ... потоках
+int run_parallel_mode(int argc, char* argv[], const string& filename, int total_lines) {
+    unsigned max_threads = argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : max(1u, thread::hardware_concurrency());
+    if (max_threads == 0) {
+        cerr << "Использование: " << argv[0] << " parallel [макс. потоков]" << endl;
+        return 1;
+    }
+    try {
+        RecordFile file(filename);
+        ScanCount reference;
+        for (unsigned threads = 1; ; threads = min(threads * 2, max_threads)) {
+            ThreadPool pool(threads);
+            PerfScope perf_scope("lab4/read/file/parallel/threads=" + to_string(threads));
+            perf_scope.set_threads(threads);
+            auto start = chrono::high_resolution_clock::now();
+            ScanCount result = count_file_parallel(file, pool, total_lines);
+            auto end = chrono::high_resolution_clock::now();
+            perf_scope.stop();
+            chrono::duration<double> duration = end - start;
+            cout << "Потоков: " << threads << ", время: " << duration.count() << " секунд, "
+                 << result.bytes / duration.count() / 1e9 << " ГБ/с, прочитано строк: " << result.records << endl;
+            if (threads == 1) {
+                reference = result;
+            } else if (result.records != reference.records || result.bytes != reference.bytes) {
+                cerr << "Результат в " << threads << " потоках не совпадает с однопоточным" << endl;
+                return 1;
+            }
+            if (threads == max_threads) break;
+        }
+    } catch (const runtime_error& e) {
+        cerr << "Ошибка открытия файла: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     int total_lines = 3000000; 
-    read_from_file("../write-on-file/data.txt", total_lines);  // Чтение из файла
-    read_from_sqlite("../write-on-database/database.db", total_lines);  // Чтение из SQLite3
-    read_from_sqlite("../write-on-database/database.db", total_lines);  // Чтение из SQLite3
-    read_from_file("../write-on-file/data.txt", total_lines);  // Чтение из файла
+    const string filename = "../write-on-file/data.txt";
+    const string db_name = "../write-on-database/database.db";
+    if (argc > 1 && string(argv[1]) == "bench") {
+        BenchRegistry registry;
+        registry.add("lab4/read/file/ifstream", [&] { do_not_optimize(count_file_ifstream(filename, total_lines)); });
+        registry.add("lab4/read/file/mmap", [&] { do_not_optimize(count_file_mmap(filename, total_lines)); });
+        registry.add("lab4/read/sqlite", [&] { do_not_optimize(count_sqlite(db_name, total_lines)); });
+        unique_ptr<RecordFile> file;
+        vector<unique_ptr<ThreadPool>> pools;
+        try {
+            file = make_unique<RecordFile>(filename);
+        } catch (const runtime_error& e) {
+            cerr << "Ошибка открытия файла: " << e.what() << endl;
+        }
+        for (unsigned threads = 1; file && threads <= max(1u, thread::hardware_concurrency()); threads *= 2) {
+            ThreadPool* pool = pools.emplace_back(make_unique<ThreadPool>(threads)).get();
+            registry.add("lab4/read/file/parallel/threads=" + to_string(threads),
+                         [&, pool] { do_not_optimize(count_file_parallel(*file, *pool, total_lines).records); }, threads);
+        }
+        return registry.main(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "parallel") {
+        return run_parallel_mode(argc, argv, filename, total_lines);
+    }
+    read_from_file(filename, total_lines);  // Чтение из файла
+    read_from_sqlite(db_name, total_lines);  // Чтение из SQLite3
+    read_from_sqlite(db_name, total_lines);  // Чтение из SQLite3
+    read_from_file(filename, total_lines);  // Чтение из файла
+    read_from_file_mmap(filename, total_lines);  // Чтение из файла через mmap
     return 0;
-}
\ No newline at end of file
+}
@@ -1,36 +1,28 @@
 #include <sqlite3.h>
 #include <iostream>
 #include <fstream>
-#include <random>
 #include <chrono>
+#include <cstdlib>
 #include <string>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../../common/perf_counters.h"
+#include "../../common/random_string.h"
 
 using namespace std;
 
 
-// Функция для генерации случайной строки, содержащей только латинские буквы и цифры
-string generate_random_string(int length) {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> dis(48, 57);  // Для цифр
-    uniform_int_distribution<> dis_upper(65, 90);  // Для заглавных букв
-    uniform_int_distribution<> dis_lower(97, 122);  // Для строчных букв
-    string result(length, ' ');
-    for (int i = 0; i < length; ++i) {
-        int rand_choice = rand() % 3;  // Выбираем случайно, что добавить в строку
-        if (rand_choice == 0) {
-            result[i] = static_cast<char>(dis(gen));  // Цифра
-        } else if (rand_choice == 1) {
-            result[i] = static_cast<char>(dis_upper(gen));  // Заглавная буква
-        } else {
-            result[i] = static_cast<char>(dis_lower(gen));  // Строчная буква
-        }
-    }
-    return result;
-}
+// Строки генерирует RandomStringGenerator: один генератор на весь набор данных, задается seed
+const uint64_t SEED = 42;
 
 // Функция для записи строк в SQLite3
-chrono::duration<double>  write_to_sqlite(const string& db_name, int total_lines, int max_length) {
+chrono::duration<double>  write_to_sqlite(const string& db_name, int total_lines, int max_length,
+                                           RandomStringGenerator& gen) {
     chrono::duration<double> duration(0);
     sqlite3* db;
     char* err_msg = nullptr;
@@ -51,8 +43,8 @@ chrono::duration<double>  write_to_sqlite(const string& db_name, int total_lines
     // Вставляем данные в таблицу
     sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, nullptr); // Начинаем транзакцию
     for (int i = 0; i < total_lines; ++i) {
-        int length = rand() % (max_length + 1);
-        string str = generate_random_string(length);
+        int length = static_cast<int>(gen.uniform(max_length + 1));
+        const string& str = gen.next(length);
         start = chrono::high_resolution_clock::now();
         // Подготовка SQL-запроса
         string insert_sql = "INSERT INTO strings (length, data) VALUES (" + to_string(length) + ", '" + str + "');";
@@ -73,11 +65,226 @@ chrono::duration<double>  write_to_sqlite(const string& db_name, int total_lines
     return duration;
 }
 
-int main() {
+// Настройки загрузки подготовленным запросом
+struct BulkOptions {
+    int batch = 100000;        // строк в одной транзакции
+    string journal_mode;       // PRAGMA journal_mode; пусто - как по умолчанию в SQLite
+    string synchronous;        // PRAGMA synchronous
+    int page_size = 0;         // PRAGMA page_size, действует только для новой базы; 0 - по умолчанию
+    int cache_size = 0;        // PRAGMA cache_size (<0 - в КБ); 0 - по умолчанию
+    bool producer = false;     // строки генерирует отдельный поток
+    uint64_t seed = SEED;      // одинаковый seed - одинаковые строки при любом batch и producer
+};
+
+using Row = pair<int, string>;
+
+// Очередь пачек строк от генератора к записи; не больше capacity пачек в памяти
+class BatchQueue {
+public:
+    explicit BatchQueue(size_t capacity) : capacity(capacity) {}
+
+    // false - очередь закрыта, генератору пора остановиться
+    bool push(vector<Row> batch) {
+        unique_lock<mutex> lock(mtx);
+        not_full.wait(lock, [this] { return closed || batches.size() < capacity; });
+        if (closed) return false;
+        batches.push_back(move(batch));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // Пустая пачка - генератор закончил или очередь закрыта
+    vector<Row> pop() {
+        unique_lock<mutex> lock(mtx);
+        not_empty.wait(lock, [this] { return closed || !batches.empty(); });
+        if (batches.empty()) return {};
+        vector<Row> batch = move(batches.front());
+        batches.pop_front();
+        not_full.notify_one();
+        return batch;
+    }
+
+    // Запись прервана: ждущий push возвращает false, очередь больше не принимает пачек
+    void close() {
+        {
+            lock_guard<mutex> lock(mtx);
+            closed = true;
+            batches.clear();
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    mutex mtx;
+    condition_variable not_empty, not_full;
+    deque<vector<Row>> batches;
+    bool closed = false;
+};
+
+vector<Row> generate_batch(int rows, int max_length, RandomStringGenerator& gen) {
+    vector<Row> batch;
+    batch.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        int length = static_cast<int>(gen.uniform(max_length + 1));
+        batch.emplace_back(length, gen.next(length));
+    }
+    return batch;
+}
+
+bool exec_sql(sqlite3* db, const string& sql) {
+    char* err_msg = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK) {
+        cerr << "Ошибка SQL (" << sql << "): " << err_msg << endl;
+        sqlite3_free(err_msg);
+        return false;
+    }
+    return true;
+}
+
+// Запись одним подготовленным INSERT с sqlite3_bind_* и sqlite3_reset, по opts.batch строк
+// в транзакции. Возвращает время вставок (без генерации строк, как write_to_sqlite);
+// в wall_time - полное время загрузки вместе с генерацией. При первой ошибке SQLite
+// (PRAGMA, BEGIN, INSERT, COMMIT) загрузка прекращается и возвращается nullopt.
+optional<chrono::duration<double>> write_to_sqlite_bulk(const string& db_name, int total_lines, int max_length,
+                                                        const BulkOptions& opts, chrono::duration<double>& wall_time) {
+    chrono::duration<double> duration(0);
+    auto wall_start = chrono::high_resolution_clock::now();
+    sqlite3* db;
+    if (sqlite3_open(db_name.c_str(), &db)) {
+        cerr << "Ошибка открытия базы данных: " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(db);
+        return nullopt;
+    }
+    vector<string> pragmas;
+    if (opts.page_size > 0) pragmas.push_back("PRAGMA page_size = " + to_string(opts.page_size) + ";");
+    if (!opts.journal_mode.empty()) pragmas.push_back("PRAGMA journal_mode = " + opts.journal_mode + ";");
+    if (!opts.synchronous.empty()) pragmas.push_back("PRAGMA synchronous = " + opts.synchronous + ";");
+    if (opts.cache_size != 0) pragmas.push_back("PRAGMA cache_size = " + to_string(opts.cache_size) + ";");
+    pragmas.push_back("CREATE TABLE IF NOT EXISTS strings (id INTEGER PRIMARY KEY, length INTEGER, data TEXT);");
+    for (const string& sql : pragmas) {
+        if (!exec_sql(db, sql)) {
+            sqlite3_close(db);
+            return nullopt;
+        }
+    }
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "INSERT INTO strings (length, data) VALUES (?, ?);", -1, &stmt, nullptr) != SQLITE_OK) {
+        cerr << "Ошибка при подготовке запроса: " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(db);
+        return nullopt;
+    }
+
+    // Генератор в отдельном потоке заполняет очередь, пока запись идет в базу
+    const int batch_rows = max(1, opts.batch);
+    RandomStringGenerator gen(opts.seed);
+    BatchQueue queue(4);
+    thread producer;
+    if (opts.producer) {
+        producer = thread([&] {
+            for (int done = 0; done < total_lines; done += batch_rows) {
+                if (!queue.push(generate_batch(min(batch_rows, total_lines - done), max_length, gen))) return;
+            }
+            queue.push({});
+        });
+    }
+
+    bool ok = true;
+    for (int done = 0; done < total_lines;) {
+        vector<Row> batch = opts.producer ? queue.pop() : generate_batch(min(batch_rows, total_lines - done), max_length, gen);
+        if (batch.empty()) break;
+        auto start = chrono::high_resolution_clock::now();
+        ok = exec_sql(db, "BEGIN TRANSACTION;");
+        for (size_t i = 0; ok && i < batch.size(); ++i) {
+            const string& str = batch[i].second;
+            sqlite3_bind_int(stmt, 1, batch[i].first);
+            sqlite3_bind_text(stmt, 2, str.data(), static_cast<int>(str.size()), SQLITE_STATIC);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                cerr << "Ошибка при вставке данных: " << sqlite3_errmsg(db) << endl;
+                ok = false;
+            }
+            sqlite3_reset(stmt);
+        }
+        ok = ok && exec_sql(db, "COMMIT;");
+        auto end = chrono::high_resolution_clock::now();
+        duration += end - start;
+        if (!ok) break;  // незавершенную транзакцию откатит sqlite3_close
+        done += static_cast<int>(batch.size());
+    }
+    // При ошибке записи очередь закрывается, и генератор останавливается, не дописывая набор
+    if (producer.joinable()) {
+        if (!ok) queue.close();
+        producer.join();
+    }
+
+    auto start = chrono::high_resolution_clock::now();
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    auto end = chrono::high_resolution_clock::now();
+    duration += end - start;
+    wall_time = end - wall_start;
+    if (!ok) return nullopt;
+    return duration;
+}
+
+// main.exe [seed] - построчный sqlite3_exec, как раньше;
+// main.exe bulk [--batch=N] [--journal=РЕЖИМ] [--synchronous=РЕЖИМ] [--page-size=N] [--cache-size=N]
+//               [--producer] [--lines=N] [--seed=N] - подготовленный запрос
+int run_bulk_mode(int argc, char* argv[], int total_lines, int max_length) {
+    BulkOptions opts;
+    for (int i = 2; i < argc; ++i) {
+        string arg = argv[i];
+        auto value = [&](const string& key) -> const char* {
+            return arg.compare(0, key.size(), key) == 0 ? arg.c_str() + key.size() : nullptr;
+        };
+        if (const char* v = value("--batch=")) {
+            opts.batch = atoi(v);
+        } else if (const char* v = value("--journal=")) {
+            opts.journal_mode = v;
+        } else if (const char* v = value("--synchronous=")) {
+            opts.synchronous = v;
+        } else if (const char* v = value("--page-size=")) {
+            opts.page_size = atoi(v);
+        } else if (const char* v = value("--cache-size=")) {
+            opts.cache_size = atoi(v);
+        } else if (const char* v = value("--seed=")) {
+            opts.seed = strtoull(v, nullptr, 10);
+        } else if (const char* v = value("--lines=")) {
+            total_lines = atoi(v);
+        } else if (arg == "--producer") {
+            opts.producer = true;
+        } else {
+            cerr << "Использование: " << argv[0] << " bulk [--batch=N] [--journal=WAL] [--synchronous=OFF]"
+                 << " [--page-size=N] [--cache-size=N] [--producer] [--lines=N] [--seed=N]" << endl;
+            return 1;
+        }
+    }
+    chrono::duration<double> wall_time(0);
+    PerfScope perf_scope("lab4/write/sqlite/bulk");
+    auto duration = write_to_sqlite_bulk("database.db", total_lines, max_length, opts, wall_time);
+    perf_scope.stop();
+    if (!duration) {
+        cerr << "Загрузка в SQLite3 прервана из-за ошибки" << endl;
+        return 1;
+    }
+    cout << "Время записи в SQLite3 (подготовленный запрос): " << duration->count() << " секунд." << endl;
+    cout << "Полное время загрузки с генерацией строк" << (opts.producer ? " (отдельный поток)" : "") << ": "
+         << wall_time.count() << " секунд." << endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     // 300 MB
     int total_lines = 3000000; 
     int max_length = 1000;      // k
-    auto duration = write_to_sqlite("database.db", total_lines, max_length);
+    if (argc > 1 && string(argv[1]) == "bulk") {
+        return run_bulk_mode(argc, argv, total_lines, max_length);
+    }
+    RandomStringGenerator gen(argc > 1 ? strtoull(argv[1], nullptr, 10) : SEED);
+    PerfScope perf_scope("lab4/write/sqlite");
+    auto duration = write_to_sqlite("database.db", total_lines, max_length, gen);
+    perf_scope.stop();
     cout << "Время записи в SQLite3: " << duration.count() << " секунд." << endl;
     return 0;
 }
\ No newline at end of file
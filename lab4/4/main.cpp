@@ -1,33 +1,17 @@
 #include <iostream>
 #include <fstream>
-#include <random>
 #include <chrono>
+#include <cstdlib>
 #include <string>
+#include "../../common/perf_counters.h"
+#include "../../common/random_string.h"
 
 using namespace std;
 
-// Функция для генерации случайной строки, содержащей только латинские буквы и цифры
-string generate_random_string(int length) {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> dis('0', '9');  // Для цифр
-    uniform_int_distribution<> dis_upper('A', 'Z');  // Для заглавных букв
-    uniform_int_distribution<> dis_lower('a', 'z');  // Для строчных букв
-    string result(length, ' ');
-    for (int i = 0; i < length; ++i) {
-        int rand_choice = rand() % 3;  // Выбираем случайно, что добавить в строку
-        if (rand_choice == 0) {
-            result[i] = static_cast<char>(dis(gen));  // Цифра
-        } else if (rand_choice == 1) {
-            result[i] = static_cast<char>(dis_upper(gen));  // Заглавная буква
-        } else {
-            result[i] = static_cast<char>(dis_lower(gen));  // Строчная буква
-        }
-    }
-    return result;
-}
+// Строки генерирует RandomStringGenerator: один генератор на весь файл, задается seed
+const uint64_t SEED = 42;
 
-chrono::duration<double> write_to_file(const string& filename, int total_lines, int max_length) {
+chrono::duration<double> write_to_file(const string& filename, int total_lines, int max_length, RandomStringGenerator& gen) {
     chrono::duration<double> duration(0);
     auto start = chrono::high_resolution_clock::now();
     ofstream file(filename, ios::out);
@@ -38,8 +22,8 @@ chrono::duration<double> write_to_file(const string& filename, int total_lines,
     auto end = chrono::high_resolution_clock::now();
     duration += end - start;
     for (int i = 0; i < total_lines; ++i) {
-        int length = rand() % (max_length + 1);  
-        string str = generate_random_string(length);
+        int length = static_cast<int>(gen.uniform(max_length + 1));
+        const string& str = gen.next(length);
         start = chrono::high_resolution_clock::now();
         file << length << " " << str << endl;
         end = chrono::high_resolution_clock::now();
@@ -52,12 +36,16 @@ chrono::duration<double> write_to_file(const string& filename, int total_lines,
     return duration;
 }
 
-int main() {
+// main.exe [seed]
+int main(int argc, char* argv[]) {
     // 300 MB
     int total_lines = 3000000;  
     int max_length = 1000;      
     //auto start = chrono::high_resolution_clock::now();
-    auto duration = write_to_file("data.txt", total_lines, max_length);
+    RandomStringGenerator gen(argc > 1 ? strtoull(argv[1], nullptr, 10) : SEED);
+    PerfScope perf_scope("lab4/write/file");
+    auto duration = write_to_file("data.txt", total_lines, max_length, gen);
+    perf_scope.stop();
     //auto end = chrono::high_resolution_clock::now();
     //chrono::duration<double> duration = end - start;
     cout << "Время записи в файл: " << duration.count() << " секунд." << endl;
@@ -9,6 +9,16 @@
 #include <cstdlib>
 #include <clocale>
 
+// pikchr лежит рядом в pikchr\pikchr.exe на Windows и ищется в PATH на Linux;
+// можно переопределить при сборке: -DPIKCHR_COMMAND='"/path/to/pikchr"'
+#ifndef PIKCHR_COMMAND
+  #ifdef _WIN32
+    #define PIKCHR_COMMAND "pikchr\\pikchr.exe"
+  #else
+    #define PIKCHR_COMMAND "pikchr"
+  #endif
+#endif
+
 namespace fs = std::filesystem;
 
 // --- Настройки генерации ---
@@ -37,7 +47,10 @@ std::string random_name(std::mt19937& rng) {
 }
 
 int main() {
-    std::setlocale(LC_ALL, "Russian");
+    // "Russian" есть только на Windows; на Linux берется локаль окружения (например, ru_RU.UTF-8)
+    if (!std::setlocale(LC_ALL, "Russian")) {
+        std::setlocale(LC_ALL, "");
+    }
     std::mt19937 rng(std::random_device{}());
     std::ofstream out("big_groups.pikchr");
     size_t total_bytes = 0;
@@ -61,7 +74,7 @@ int main() {
 
     // --- Замер времени генерации SVG ---
     auto start = std::chrono::high_resolution_clock::now();
-    int ret = std::system("pikchr\\pikchr.exe --svg-only big_groups.pikchr > big_groups.svg");
+    int ret = std::system(PIKCHR_COMMAND " --svg-only big_groups.pikchr > big_groups.svg");
     auto end = std::chrono::high_resolution_clock::now();
 
     if (ret != 0) {
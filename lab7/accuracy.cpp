@@ -0,0 +1,181 @@
+// accuracy.cpp - точность и скорость ядер решения квадратных уравнений
+// Сборка: g++ -std=c++20 -O2 [-mfma] -o accuracy.exe accuracy.cpp
+// Запуск: accuracy.exe [число уравнений]
+#include <iostream>
+#include <vector>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include "../common/philox.h"
+#include "../common/quadratic.h"
+
+#define NUM 50'000'000
+#define SEED 42
+#define BATCH 4096
+#define CHUNK (1 << 20)  // уравнений на кусок: эталон и корни хранятся только для куска
+
+using namespace std;
+using namespace chrono;
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define ACCURACY_X86 1
+#endif
+
+// Решение куска уравнений; ядро - параметр шаблона, поэтому встраивается в цикл
+// и время не включает косвенный вызов на каждое уравнение
+template <auto Kernel>
+void solve_chunk(const double *a, const double *b, const double *c,
+                 double *x1, double *x2, int8_t *roots, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        roots[i] = static_cast<int8_t>(Kernel(a[i], b[i], c[i], x1[i], x2[i]));
+    }
+}
+
+using ChunkSolver = void (*)(const double *, const double *, const double *, double *, double *, int8_t *, size_t);
+
+#if defined(ACCURACY_X86) && !defined(__FMA__)
+// Без -mfma std::fma - вызов libm; копия цикла под target("fma") выбирается во время выполнения
+__attribute__((target("fma"), flatten))
+void solve_chunk_stable_fma(const double *a, const double *b, const double *c,
+                            double *x1, double *x2, int8_t *roots, size_t n) {
+    solve_chunk<solve_quadratic_stable<true>>(a, b, c, x1, x2, roots, n);
+}
+
+ChunkSolver stable_fma_solver() {
+    return __builtin_cpu_supports("fma") ? solve_chunk_stable_fma : solve_chunk<solve_quadratic_stable<true>>;
+}
+#else
+ChunkSolver stable_fma_solver() {
+    return solve_chunk<solve_quadratic_stable<true>>;
+}
+#endif
+
+struct Reference {
+    int num_roots;
+    long double lo, hi;
+};
+
+// Дискриминант b^2 - 4ac почти без округления: b^2 и ac - точные пары hi + lo через
+// ошибку fma, старшие части вычитаются без потерь (TwoSum), младшие - поправкой.
+// Погрешность порядка 2^-100 * b^2, так что и при b^2 ~ 4ac знак и значение D надежны,
+// а эталон не уступает discriminant_fma даже там, где long double совпадает с double.
+// Сжатие b * b - ac4 в fma (GCC с -mfma по умолчанию) сломало бы TwoSum, поэтому оно отключено.
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("fp-contract=off")))
+#endif
+long double exact_discriminant(double a, double b, double c) {
+    double bb = b * b, bb_lo = fma(b, b, -bb);
+    double ac4 = 4 * (a * c), ac4_lo = 4 * fma(a, c, -(a * c));  // умножение на 4 точное
+    double hi = bb - ac4;
+    double t = hi - bb;
+    double hi_err = (bb - (hi - t)) + (-ac4 - t);
+    return static_cast<long double>(hi) + (static_cast<long double>(hi_err) + (bb_lo - ac4_lo));
+}
+
+// Эталон в long double по устойчивой формуле с точным дискриминантом; корни по возрастанию
+Reference reference_roots(double a, double b, double c) {
+    long double la = a, lb = b, lc = c;
+    long double d = exact_discriminant(a, b, c);
+    if (d < 0) return {0, 0, 0};
+    long double q = -0.5L * (lb + copysignl(sqrtl(d), lb));
+    long double r1 = q / la;
+    long double r2 = (q != 0) ? lc / q : r1;
+    return {d > 0 ? 2 : 1, min(r1, r2), max(r1, r2)};
+}
+
+// Расстояние в ULP между двумя double через упорядоченное целое представление
+uint64_t ulp_distance(double x, double y) {
+    auto ordered = [](double v) {
+        int64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        return bits < 0 ? INT64_MIN - bits : bits;
+    };
+    int64_t ix = ordered(x), iy = ordered(y);
+    return ix > iy ? uint64_t(ix) - uint64_t(iy) : uint64_t(iy) - uint64_t(ix);
+}
+
+// Накопленные по кускам время и ошибки одного ядра
+struct VariantStats {
+    double elapsed = 0;
+    uint64_t max_ulp = 0;
+    double sum_ulp = 0;
+    size_t compared = 0, mismatched = 0;
+};
+
+int main(int argc, char *argv[]) {
+    size_t num = argc > 1 ? strtoull(argv[1], nullptr, 10) : NUM;
+
+    struct Variant {
+        const char *name;
+        ChunkSolver solve;
+    };
+    const Variant variants[] = {
+        {"classic",    solve_chunk<solve_quadratic_classic>},
+        {"stable",     solve_chunk<solve_quadratic_stable<false>>},
+        {"stable_fma", stable_fma_solver()},
+        {"stable_rcp", solve_chunk<solve_quadratic_stable_rcp>},
+    };
+    constexpr size_t NUM_VARIANTS = sizeof(variants) / sizeof(variants[0]);
+    VariantStats stats[NUM_VARIANTS];
+
+    // Тот же набор данных, что и в main.cpp: поток Philox идет по кускам в том же порядке,
+    // поэтому коэффициенты не зависят от CHUNK. Эталон считается один раз на кусок.
+    vector<double> A(CHUNK), B(CHUNK), C(CHUNK), X1(CHUNK), X2(CHUNK);
+    vector<int8_t> roots(CHUNK);
+    vector<Reference> ref(CHUNK);
+    PhiloxGenerator gen(SEED);
+    cout << "Solving " << num << " equations\n";
+    if (LDBL_MANT_DIG == DBL_MANT_DIG) {
+        cout << "Note: long double is double here, reference roots carry up to ~1 ULP of their own\n";
+    }
+    for (size_t chunk_start = 0; chunk_start < num; chunk_start += CHUNK) {
+        size_t chunk = min<size_t>(CHUNK, num - chunk_start);
+        for (size_t done = 0; done < chunk; done += BATCH) {
+            size_t n = min<size_t>(BATCH, chunk - done);
+            gen.fill_nonzero({A.data() + done, n}, -1000.0, 1000.0, 1e-6);
+            gen.fill({B.data() + done, n}, -1000.0, 1000.0);
+            gen.fill({C.data() + done, n}, -1000.0, 1000.0);
+        }
+        for (size_t i = 0; i < chunk; ++i) {
+            ref[i] = reference_roots(A[i], B[i], C[i]);
+        }
+
+        for (size_t k = 0; k < NUM_VARIANTS; ++k) {
+            VariantStats &st = stats[k];
+            auto start = high_resolution_clock::now();
+            variants[k].solve(A.data(), B.data(), C.data(), X1.data(), X2.data(), roots.data(), chunk);
+            auto end = high_resolution_clock::now();
+            st.elapsed += duration<double>(end - start).count();
+
+            for (size_t i = 0; i < chunk; ++i) {
+                if ((roots[i] > 0) != (ref[i].num_roots > 0)) {
+                    ++st.mismatched;
+                    continue;
+                }
+                if (roots[i] == 0) continue;
+                double lo = min(X1[i], X2[i]), hi = max(X1[i], X2[i]);
+                uint64_t ulp = max(ulp_distance(lo, static_cast<double>(ref[i].lo)),
+                                   ulp_distance(hi, static_cast<double>(ref[i].hi)));
+                st.max_ulp = max(st.max_ulp, ulp);
+                st.sum_ulp += static_cast<double>(ulp);
+                ++st.compared;
+            }
+        }
+    }
+
+    for (size_t k = 0; k < NUM_VARIANTS; ++k) {
+        const VariantStats &st = stats[k];
+        cout << "Kernel: " << variants[k].name
+             << " | Time=" << st.elapsed << " s"
+             << " | Throughput=" << num / st.elapsed / 1e6 << " M eq/s"
+             << " | MaxULP=" << st.max_ulp
+             << " | MeanULP=" << (st.compared ? st.sum_ulp / st.compared : 0.0)
+             << " | RootCountMismatch=" << st.mismatched
+             << "\n";
+    }
+    return 0;
+}
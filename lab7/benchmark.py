@@ -2,6 +2,7 @@ import subprocess
 import time
 import os
 import csv
+import json
 import matplotlib.pyplot as plt
 
 levels = ['O0', 'O1', 'O2', 'O3', 'Os']
@@ -15,7 +16,7 @@ for level in levels:
     exe_file = exe_template.format(level)
     # Время сборки
     start_build = time.perf_counter()
-    build = subprocess.run(['g++', f'-{level}', '-o', exe_file, cpp_file], capture_output=True)
+    build = subprocess.run(['g++', '-std=c++20', f'-{level}', '-pthread', '-o', exe_file, cpp_file], capture_output=True)
     end_build = time.perf_counter()
     build_time = end_build - start_build
 
@@ -26,22 +27,25 @@ for level in levels:
     # Размер файла
     file_size = os.path.getsize(exe_file) / 1024  # КБ
 
-    # Время выполнения
-    start_run = time.perf_counter()
-    run = subprocess.run([exe_file], capture_output=True)
-    end_run = time.perf_counter()
-    run_time = end_run - start_run
+    # Время ядер: общий микробенчмарк (main.exe bench), медиана одного повторения из JSON
+    run = subprocess.run([os.path.abspath(exe_file), 'bench', '--format=json'], capture_output=True,
+                         text=True, encoding='utf-8')
+    if run.returncode != 0:
+        print(f'Ошибка запуска для -{level}:', run.stderr)
+        continue
+    medians = {b['name']: b['median'] for b in json.loads(run.stdout)['benchmarks']}
 
     results.append({
         'level': level,
         'build_time': build_time,
-        'run_time': run_time,
-        'file_size': file_size
+        'file_size': file_size,
+        **medians
     })
 
-# Сохраняем в CSV
+# Сохраняем в CSV: по столбцу на ядро (медиана, сек)
+kernels = [name for name in results[0] if name not in ('level', 'build_time', 'file_size')] if results else []
 with open(csv_file, 'w', newline='', encoding='utf-8') as f:
-    writer = csv.DictWriter(f, fieldnames=['level', 'build_time', 'run_time', 'file_size'])
+    writer = csv.DictWriter(f, fieldnames=['level', 'build_time', 'file_size'] + kernels)
     writer.writeheader()
     for row in results:
         writer.writerow(row)
@@ -51,7 +55,6 @@ print(f'Результаты сохранены в {csv_file}')
 # Строим графики
 levels = [r['level'] for r in results]
 build_times = [r['build_time'] for r in results]
-run_times = [r['run_time'] for r in results]
 file_sizes = [r['file_size'] for r in results]
 
 plt.figure(figsize=(12, 4))
@@ -63,10 +66,15 @@ plt.xlabel('Уровень оптимизации')
 plt.ylabel('Время, сек')
 
 plt.subplot(1, 3, 2)
-plt.bar(levels, run_times, color='lightgreen')
-plt.title('Время выполнения (сек)')
+width = 0.8 / max(len(kernels), 1)
+for k, kernel in enumerate(kernels):
+    offset = (k - (len(kernels) - 1) / 2) * width
+    plt.bar([i + offset for i in range(len(levels))], [r.get(kernel, 0) for r in results], width, label=kernel)
+plt.xticks(range(len(levels)), levels)
+plt.title('Медиана времени ядра (сек)')
 plt.xlabel('Уровень оптимизации')
 plt.ylabel('Время, сек')
+plt.legend(fontsize='small')
 
 plt.subplot(1, 3, 3)
 plt.bar(levels, file_sizes, color='salmon')
@@ -1,22 +1,28 @@
 #include <iostream>
 #include <vector>
+#include <memory>
 #include <cmath>
-#include <random>
 #include <chrono>
 #include <fstream>
+#include <string>
+#include <cstdlib>
+#include "../common/philox.h"
+#include "../common/equation_columns.h"
+#include "../common/solver_pipeline.h"
+#include "../common/result_file.h"
+#include "../common/perf_counters.h"
+#include "../common/bench.h"
 
 #define NUM 50'000'000
 #define SEED 42
+#define BATCH 4096
+// Размер куска и длина кольца для потокового режима
+#define STREAM_CHUNK (16 * BATCH)
+#define STREAM_RING 4
 
 using namespace std;
 using namespace chrono;
 
-struct EquationResult {
-    double a, b, c;
-    int num_roots;
-    double root1, root2;
-};
-
 int solve_quadratic(double a, double b, double c, double &x1, double &x2) {
     double d = b * b - 4 * a * c;
     if (d > 0) {
@@ -33,23 +39,174 @@ int solve_quadratic(double a, double b, double c, double &x1, double &x2) {
     }
 }
 
-int main() {
-    mt19937 rng(SEED);
-    uniform_real_distribution<double> dist(-1000.0, 1000.0);
-    vector<EquationResult> results;
-    results.reserve(NUM);
+// Коэффициенты пакета из n <= BATCH уравнений; пакеты берутся из потока подряд.
+// |a| >= 1e-6 обеспечивается отображением отрезка, а не циклом отбраковки
+void generate_batch(PhiloxGenerator &gen, double *a, double *b, double *c, size_t n) {
+    gen.fill_nonzero({a, n}, -1000.0, 1000.0, 1e-6);
+    gen.fill({b, n}, -1000.0, 1000.0);
+    gen.fill({c, n}, -1000.0, 1000.0);
+}
+
+// Стадии потокового режима: коэффициенты куска пакетами из gen (кусок за куском - тот же
+// поток, что и без кусков) и решение куска
+void generate_chunk(PhiloxGenerator &gen, SolverChunk &chunk) {
+    for (size_t i = 0; i < chunk.size; i += BATCH) {
+        size_t n = min<size_t>(BATCH, chunk.size - i);
+        generate_batch(gen, chunk.a.data() + i, chunk.b.data() + i, chunk.c.data() + i, n);
+    }
+}
+
+void solve_chunk(SolverChunk &chunk) {
+    for (size_t i = 0; i < chunk.size; ++i) {
+        chunk.num_roots[i] = static_cast<uint8_t>(
+            solve_quadratic(chunk.a[i], chunk.b[i], chunk.c[i], chunk.x1[i], chunk.x2[i]));
+    }
+}
+
+// Потоковый режим: main.exe stream [count | hist | file <путь>] [число уравнений]
+// Память ограничена кольцом из STREAM_RING кусков при любом числе уравнений
+int run_stream(int argc, char *argv[]) {
+    string sink_name = argc > 2 ? argv[2] : "count";
+    int next_arg = 3;
+    string path;
+    if (sink_name == "file") {
+        path = argc > 3 ? argv[3] : "results.bin";
+        next_arg = 4;
+    }
+    size_t num = argc > next_arg ? strtoull(argv[next_arg], nullptr, 10) : NUM;
+
+    CountSink counter;
+    HistogramSink histogram(-100.0, 100.0, 20);
+    unique_ptr<FileSink> file;
+    ChunkSink *sink = &counter;
+    if (sink_name == "hist") {
+        sink = &histogram;
+    } else if (sink_name == "file") {
+        try {
+            file = make_unique<FileSink>(path, num);
+        } catch (const exception &e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        sink = file.get();
+    } else if (sink_name != "count") {
+        cerr << "Неизвестный приемник: " << sink_name << endl;
+        return 1;
+    }
+
+    PhiloxGenerator gen(SEED);
+
+    PerfScope perf_scope("lab7/stream");
+    perf_scope.set_threads(SOLVER_PIPELINE_THREADS);
+    auto start = high_resolution_clock::now();
+    try {
+        run_solver_pipeline(num, STREAM_CHUNK, STREAM_RING,
+                            [&gen](SolverChunk &chunk) { generate_chunk(gen, chunk); }, solve_chunk, *sink);
+    } catch (const exception &e) {
+        cerr << "Ошибка потокового режима: " << e.what() << endl;
+        return 1;
+    }
+    auto end = high_resolution_clock::now();
+    perf_scope.stop();
+    double elapsed = duration<double>(end - start).count();
+    cout << "Solved " << num << " equations in " << elapsed << " seconds." << endl;
+    if (sink == &counter) {
+        cout << "Roots: 0 -> " << counter.counts[0] << ", 1 -> " << counter.counts[1]
+             << ", 2 -> " << counter.counts[2] << endl;
+    } else if (sink == &histogram) {
+        for (size_t k = 0; k < histogram.bins.size(); ++k) {
+            cout << "bin " << k << ": " << histogram.bins[k] << endl;
+        }
+    } else {
+        cout << "Results written to " << path << endl;
+    }
+    return 0;
+}
+
+// Режим bench: main.exe bench [опции bench.h] - отдельные стадии на BENCH_NUM уравнениях
+#define BENCH_NUM (256 * BATCH)
+int run_bench(int argc, char *argv[]) {
+    vector<double> as(BENCH_NUM), bs(BENCH_NUM), cs(BENCH_NUM), x1s(BENCH_NUM), x2s(BENCH_NUM);
+    vector<uint8_t> ns(BENCH_NUM);
+    auto generate_all = [&] {
+        PhiloxGenerator gen(SEED);
+        for (size_t done = 0; done < BENCH_NUM; done += BATCH) {
+            generate_batch(gen, as.data() + done, bs.data() + done, cs.data() + done, BATCH);
+        }
+    };
+    generate_all();
+
+    BenchRegistry registry;
+    registry.add("lab7/generate", [&] {
+        generate_all();
+        do_not_optimize(as.data());
+    });
+    registry.add("lab7/solve", [&] {
+        for (size_t i = 0; i < BENCH_NUM; ++i) {
+            ns[i] = static_cast<uint8_t>(solve_quadratic(as[i], bs[i], cs[i], x1s[i], x2s[i]));
+        }
+        do_not_optimize(ns.data());
+    });
+    for (bool store_inputs : {false, true}) {
+        registry.add(string("lab7/solve+columns") + (store_inputs ? "+inputs" : ""), [&, store_inputs] {
+            EquationColumns results(BENCH_NUM, store_inputs);
+            results.solve_append(as.data(), bs.data(), cs.data(), BENCH_NUM, solve_quadratic);
+            results.finish();
+            do_not_optimize(results.size());
+        });
+    }
+    registry.add("lab7/stream/count", [&] {
+        CountSink counter;
+        PhiloxGenerator gen(SEED);
+        run_solver_pipeline(BENCH_NUM, STREAM_CHUNK, STREAM_RING,
+                            [&gen](SolverChunk &chunk) { generate_chunk(gen, chunk); }, solve_chunk, counter);
+        do_not_optimize(counter.counts);
+    }, SOLVER_PIPELINE_THREADS);
+    return registry.main(argc, argv);
+}
+
+// Запуск: main.exe [--inputs] [save <путь>] - решение в памяти, по желанию с сохранением результатов
+//                                             в файл; --inputs - хранить и коэффициенты (41 байт
+//                                             на уравнение вместо 17)
+//         main.exe stream ...       - потоковый режим
+//         main.exe bench ...        - стадии через общий микробенчмарк
+int main(int argc, char *argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return run_bench(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "stream") {
+        return run_stream(argc, argv);
+    }
+    int arg = 1;
+    bool store_inputs = argc > arg && string(argv[arg]) == "--inputs";
+    if (store_inputs) ++arg;
+    string save_path = (argc > arg + 1 && string(argv[arg]) == "save") ? argv[arg + 1] : "";
+    PhiloxGenerator gen(SEED);
+    vector<double> as(BATCH), bs(BATCH), cs(BATCH);
+    EquationColumns results(NUM, store_inputs);
+    PerfScope perf_scope("lab7/solve");
     auto start = high_resolution_clock::now();
-    for (size_t i = 0; i < NUM; ++i) {
-        double a = dist(rng);
-        while (fabs(a) < 1e-6) a = dist(rng);
-        double b = dist(rng);
-        double c = dist(rng);
-        double x1, x2;
-        int num_roots = solve_quadratic(a, b, c, x1, x2);
-        results.push_back({a, b, c, num_roots, x1, x2});
+    for (size_t done = 0; done < NUM; done += BATCH) {
+        size_t n = min<size_t>(BATCH, NUM - done);
+        generate_batch(gen, as.data(), bs.data(), cs.data(), n);
+        results.solve_append(as.data(), bs.data(), cs.data(), n, solve_quadratic);
     }
+    results.finish();
     auto end = high_resolution_clock::now();
+    perf_scope.stop();
     double elapsed = duration<double>(end - start).count();
     cout << "Solved " << NUM << " equations in " << elapsed << " seconds." << endl;
+    cout << "Results memory: " << results.bytes() / (1024 * 1024) << " MB" << endl;
+    if (!save_path.empty()) {
+        ResultFileWriter writer(save_path, results.size(), results.stores_inputs());
+        size_t rows = results.size();
+        writer.append({results.a_column(), results.stores_inputs() ? rows : 0},
+                      {results.b_column(), results.stores_inputs() ? rows : 0},
+                      {results.c_column(), results.stores_inputs() ? rows : 0},
+                      {results.root1_column(), rows}, {results.root2_column(), rows},
+                      {results.num_roots_column(), rows});
+        writer.close();
+        cout << "Results written to " << save_path << endl;
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+// read_results.cpp - сводка по файлу результатов, записанному main.exe save/stream file
+// Сборка: g++ -std=c++20 -O2 -o read_results.exe read_results.cpp
+// Запуск: read_results.exe <путь>
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "../common/result_file.h"
+
+using namespace std;
+using namespace chrono;
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        cerr << "Использование: " << argv[0] << " <файл результатов>" << endl;
+        return 1;
+    }
+    try {
+        auto start = high_resolution_clock::now();
+        ResultFileReader reader(argv[1]);
+        auto opened = high_resolution_clock::now();
+        cout << "Opened " << reader.rows() << " rows in "
+             << duration<double, milli>(opened - start).count() << " ms"
+             << " (file size " << reader.file_size() << " bytes)" << endl;
+
+        cout << "num_roots encoding: " << column_encoding_name(reader.encoding(ResultColumn::NUM_ROOTS))
+             << (reader.has_column(ResultColumn::A) ? ", with coefficients" : ", without coefficients") << endl;
+
+        reader.advise(MADV_SEQUENTIAL);
+        vector<uint8_t> num_roots = reader.num_roots();
+        span<const double> x1 = reader.column(ResultColumn::ROOT1);
+        size_t counts[3] = {0, 0, 0};
+        double sum_x1 = 0;
+        for (size_t i = 0; i < reader.rows(); ++i) {
+            ++counts[num_roots[i] < 3 ? num_roots[i] : 0];
+            if (num_roots[i] != 0) sum_x1 += x1[i];
+        }
+        auto end = high_resolution_clock::now();
+        cout << "Roots: 0 -> " << counts[0] << ", 1 -> " << counts[1] << ", 2 -> " << counts[2] << endl;
+        cout << "Sum of root1: " << sum_x1 << endl;
+        cout << "Scan time: " << duration<double>(end - opened).count() << " seconds." << endl;
+    } catch (const exception &e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -2,35 +2,107 @@ import subprocess
 import time
 import os
 import csv
+import shutil
+import sys
 import matplotlib.pyplot as plt
 
 cpp_file = 'main.cpp'
 exe_template = 'main_{opt}_{lto}.exe'
 csv_file = 'results_lto.csv'
 
+# Аргументы и тренировочного запуска PGO/BOLT, и измеряемого: режим решения в памяти с
+# фиксированным SEED, то есть профиль снимается ровно на тех данных, на которых потом
+# меряется время. Это лучший для PGO случай; на других входах выигрыш может быть меньше
+train_args = []
+
 # Оптимизации компилятора и компоновщика
 opt_levels = ['O2', 'Oz']
+# (имя, флаги LTO, PGO, BOLT); имя попадает в столбец lto файла results_lto.csv
 lto_levels = [
-    ('noLTO', []),
-    ('thinLTO', ['-flto=thin']),
-    ('fullLTO', ['-flto'])
+    ('noLTO', [], False, False),
+    ('thinLTO', ['-flto=thin'], False, False),
+    ('fullLTO', ['-flto'], False, False),
+    ('PGO', [], True, False),
+    ('fullLTO+PGO', ['-flto'], True, False),
 ]
 
+# BOLT - по флагу --bolt и только если установлен llvm-bolt
+if '--bolt' in sys.argv:
+    if shutil.which('llvm-bolt'):
+        lto_levels += [
+            ('PGO+BOLT', [], True, True),
+            ('fullLTO+PGO+BOLT', ['-flto'], True, True),
+        ]
+    else:
+        print('llvm-bolt не найден, варианты с BOLT пропущены')
+
+
+def run_step(cmd):
+    """Запускает шаг сборки; возвращает текст ошибки или None"""
+    step = subprocess.run(cmd, capture_output=True)
+    if step.returncode != 0:
+        return f'{" ".join(cmd)}:\n{step.stderr.decode(errors="replace")}'
+    return None
+
+
+def build(exe_file, opt, flags, pgo, bolt):
+    """Собирает вариант; для PGO/BOLT - весь конвейер, включая тренировочные запуски.
+    Возвращает текст ошибки или None"""
+    base_cmd = ['g++', '-std=c++20', f'-{opt}', '-o', exe_file, cpp_file] + flags
+    if not pgo:
+        return run_step(base_cmd)
+
+    # 1. Сборка с инструментированием и тренировочный запуск на том же входе, что и замер
+    #    (train_args). Имя бинарника то же, что и у итогового: по нему GCC называет файлы .gcda.
+    #    Решение в памяти однопоточное, поэтому атомарные счетчики профиля не нужны
+    profile_dir = os.path.abspath(f'pgo_{os.path.splitext(exe_file)[0]}')
+    shutil.rmtree(profile_dir, ignore_errors=True)
+    error = (run_step(base_cmd + [f'-fprofile-generate={profile_dir}'])
+             or run_step([os.path.abspath(exe_file)] + train_args))
+    if error:
+        return error
+    # Без профиля -fprofile-use молча собрал бы обычный бинарник под видом PGO
+    if not any(name.endswith('.gcda') for _, _, files in os.walk(profile_dir) for name in files):
+        return f'тренировочный запуск не записал профиль .gcda в {profile_dir}'
+
+    # 2. Пересборка по профилю; для BOLT нужны сохраненные перемещения
+    use_cmd = base_cmd + [f'-fprofile-use={profile_dir}', '-fprofile-correction']
+    if bolt:
+        use_cmd.append('-Wl,--emit-relocs')
+    error = run_step(use_cmd)
+    shutil.rmtree(profile_dir, ignore_errors=True)
+    if error or not bolt:
+        return error
+
+    # 3. BOLT: инструментирование бинарника, запуск, перекомпоновка по профилю
+    fdata = os.path.abspath(exe_file + '.fdata')
+    instrumented = exe_file + '.instr'
+    error = (run_step(['llvm-bolt', exe_file, '-instrument', f'-instrumentation-file={fdata}', '-o', instrumented])
+             or run_step([os.path.abspath(instrumented)] + train_args)
+             or run_step(['llvm-bolt', exe_file, '-o', exe_file + '.bolt', f'-data={fdata}',
+                          '-reorder-blocks=ext-tsp', '-reorder-functions=hfsort', '-split-functions',
+                          '-split-all-cold', '-icf=1']))
+    if error:
+        return error
+    os.replace(exe_file + '.bolt', exe_file)
+    os.remove(instrumented)
+    return None
+
+
 results = []
 
 for opt in opt_levels:
-    for lto_name, lto_flags in lto_levels:
+    for lto_name, lto_flags, pgo, bolt in lto_levels:
         exe_file = exe_template.format(opt=opt, lto=lto_name)
-        build_cmd = ['g++', f'-{opt}', '-o', exe_file, cpp_file] + lto_flags
 
         # Время сборки
         start_build = time.perf_counter()
-        build = subprocess.run(build_cmd, capture_output=True)
+        error = build(exe_file, opt, lto_flags, pgo, bolt)
         end_build = time.perf_counter()
         build_time = end_build - start_build
 
-        if build.returncode != 0:
-            print(f'Ошибка сборки для -{opt} {lto_name}:', build.stderr.decode())
+        if error:
+            print(f'Ошибка сборки для -{opt} {lto_name}:', error)
             continue
 
         # Размер файла
@@ -38,7 +110,7 @@ for opt in opt_levels:
 
         # Время выполнения
         start_run = time.perf_counter()
-        run = subprocess.run([exe_file], capture_output=True)
+        run = subprocess.run([os.path.abspath(exe_file)] + train_args, capture_output=True)
         end_run = time.perf_counter()
         run_time = end_run - start_run
 
@@ -65,7 +137,7 @@ build_times = [r['build_time'] for r in results]
 run_times = [r['run_time'] for r in results]
 file_sizes = [r['file_size'] for r in results]
 
-plt.figure(figsize=(15, 4))
+plt.figure(figsize=(20, 5))
 
 plt.subplot(1, 3, 1)
 plt.bar(labels, build_times, color='skyblue')
@@ -3,13 +3,27 @@
 #include <random>
 #include <chrono>
 #include <cmath>
-#include <cassert>
+#include <cstddef>
+#include <string>
+#include <functional>
+#include <numeric>
+#include <iomanip>
 #include <clocale>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 #ifdef _OPENMP
   #include <omp.h>
 #endif
+#ifdef USE_PSTL
+  #include <execution>
+#endif
+#include "../common/thread_pool.h"
+#include "../common/first_touch.h"
+#include "../common/reduce.h"
+#include "../common/perf_counters.h"
+#include "../common/bench.h"
 
 using namespace std;
 using clk = chrono::high_resolution_clock;
@@ -17,259 +31,370 @@ using clk = chrono::high_resolution_clock;
 static constexpr size_t N = 50'000'000;
 
 
-void experiment_quadratic()
-{
-    cout << "=== Часть A: решение квадратных уравнений ===\n\n";
+// ---------------------------------------------------------------------------
+// Часть A: одно шаблонное ядро, параметризованное на этапе компиляции
+//   контрактом на указатели  x  константностью границы цикла  x  политикой исполнения.
+// Все сочетания инстанцируются реестром ниже, поэтому в горячем цикле нет
+// диспетчеризации во время выполнения.
+// ---------------------------------------------------------------------------
 
-    vector<double> A(N), B(N), C(N);
-    {
-        mt19937_64 rng(42);
-        uniform_real_distribution<double> dist(-1000.0, 1000.0);
-        for (size_t i = 0; i < N; ++i) {
-            double a = dist(rng);
-            while (fabs(a) < 1e-9) {
-                a = dist(rng);
-            }
-            A[i] = a;
-            B[i] = dist(rng);
-            C[i] = dist(rng);
-        }
-    }
+// Контракты: имя, тип указателя внутри ядра, преобразование исходного указателя p.
+// Новый контракт добавляется одной строкой.
+#define QUADRATIC_CONTRACTS(X)                                                                   \
+    X(BASELINE,     double *,              p)  /* все указатели «обычные» */                      \
+    X(CONST_ALL,    const double *,        p)  /* входные указатели const double * */             \
+    X(VOLATILE_ALL, volatile double *,     p)  /* входные указатели volatile double * */          \
+    X(RESTRICT_ALL, double * __restrict__, p)  /* входные указатели double * __restrict__ */      \
+    X(ALIGNED_ALL,  const double *,                                                               \
+      static_cast<const double *>(__builtin_assume_aligned(p, alignof(max_align_t))))
 
-    enum Mode { 
-        BASE = 0,      // все указатели «обычные»
-        CONST_ALL,     // входные указатели const double *
-        VOLATILE_ALL,  // входные указатели volatile double *
-        RESTRICT_ALL   // входные указатели double * __restrict__
+#define DECLARE_CONTRACT(NAME, POINTER, WRAP)                                                    \
+    struct NAME {                                                                                \
+        using pointer = POINTER;                                                                 \
+        static constexpr const char *name = #NAME;                                               \
+        static pointer wrap(double *p) { return WRAP; }                                          \
     };
+QUADRATIC_CONTRACTS(DECLARE_CONTRACT)
+#undef DECLARE_CONTRACT
+
+static size_t loop_bound_var = N;     // «неявная» переменная
+
+// Граница цикла: переменная или константа времени компиляции
+struct VarBound {
+    static constexpr const char *name = "var";
+    static size_t get() { return loop_bound_var; }
+};
+struct ConstBound {
+    static constexpr const char *name = "const";
+    static constexpr size_t get() { return N; }
+};
+
+// Тело цикла - то же, что было во всех копиях: 2 корня при D >= 0
+static inline size_t quadratic_roots(double a, double b, double c)
+{
+    double D = b*b - 4.0*a*c;
+    if (D >= 0.0) {
+        double sd = sqrt(D);
+        double x1 = (-b + sd)/(2.0*a);
+        double x2 = (-b - sd)/(2.0*a);
+        (void)x1; (void)x2;
+        return 2;
+    }
+    return 0;
+}
 
-    size_t loop_bound_var   = N;       // «неявная» переменная
-    const size_t loop_bound_c = N;     // «явно константная»
+// Сколько потоков выполняет вариант с OpenMP; без OpenMP прагмы игнорируются и поток один
+unsigned openmp_threads()
+{
+  #ifdef _OPENMP
+    return static_cast<unsigned>(omp_get_max_threads());
+  #else
+    return 1;
+  #endif
+}
+
+// Общий пул для варианта POOL и параллельной свертки: один на весь запуск, а не по пулу
+// на каждое инстанцирование ядра; потоки привязываются к CPU в bind_pool_threads
+ThreadPool &kernel_pool()
+{
+    static ThreadPool pool;
+    return pool;
+}
 
-    auto run_variant = [&]( const string &name,
-                            double *a_arr_raw,
-                            double *b_arr_raw,
-                            double *c_arr_raw,
-                            bool    use_const_bound,
-                            bool    with_openmp )
+// Политики исполнения. run<Contract, Bound> возвращает число корней,
+// threads() - сколько потоков его считают.
+struct NOOMP {
+    static constexpr const char *name = "NOOMP";
+    static constexpr bool openmp = false;
+    static unsigned threads() { return 1; }
+    template <typename Contract, typename Bound>
+    static size_t run(double *a_raw, double *b_raw, double *c_raw)
     {
-        Mode mode = BASE;
-        if      (name.rfind("BASELINE",    0) == 0) mode = BASE;
-        else if (name.rfind("CONST_ALL",   0) == 0) mode = CONST_ALL;
-        else if (name.rfind("VOLATILE_ALL",0) == 0) mode = VOLATILE_ALL;
-        else if (name.rfind("RESTRICT_ALL",0) == 0) mode = RESTRICT_ALL;
-        else {
-            assert(false && "run_variant: неизвестный режим");
+        typename Contract::pointer a_arr = Contract::wrap(a_raw);
+        typename Contract::pointer b_arr = Contract::wrap(b_raw);
+        typename Contract::pointer c_arr = Contract::wrap(c_raw);
+        size_t roots_count = 0u;
+        const size_t lb = Bound::get();
+        for (size_t i = 0; i < lb; ++i) {
+            roots_count += quadratic_roots(a_arr[i], b_arr[i], c_arr[i]);
         }
+        return roots_count;
+    }
+};
 
-        double *        a_arr      = nullptr;
-        double *        b_arr      = nullptr;
-        double *        c_arr      = nullptr;
-        const double *  a_arr_c    = nullptr;
-        const double *  b_arr_c    = nullptr;
-        const double *  c_arr_c    = nullptr;
-        volatile double *a_arr_v   = nullptr;
-        volatile double *b_arr_v   = nullptr;
-        volatile double *c_arr_v   = nullptr;
-        double * __restrict__ a_arr_r = nullptr;
-        double * __restrict__ b_arr_r = nullptr;
-        double * __restrict__ c_arr_r = nullptr;
-
-        switch (mode) {
-            case BASE:
-                a_arr = a_arr_raw;
-                b_arr = b_arr_raw;
-                c_arr = c_arr_raw;
-                break;
-            case CONST_ALL:
-                a_arr_c = a_arr_raw;
-                b_arr_c = b_arr_raw;
-                c_arr_c = c_arr_raw;
-                break;
-            case VOLATILE_ALL:
-                a_arr_v = reinterpret_cast<volatile double*>(a_arr_raw);
-                b_arr_v = reinterpret_cast<volatile double*>(b_arr_raw);
-                c_arr_v = reinterpret_cast<volatile double*>(c_arr_raw);
-                break;
-            case RESTRICT_ALL:
-                a_arr_r = a_arr_raw;
-                b_arr_r = b_arr_raw;
-                c_arr_r = c_arr_raw;
-                break;
+struct OMP {
+    static constexpr const char *name = "OMP";
+    static constexpr bool openmp = true;
+    static unsigned threads() { return openmp_threads(); }
+    template <typename Contract, typename Bound>
+    static size_t run(double *a_raw, double *b_raw, double *c_raw)
+    {
+        typename Contract::pointer a_arr = Contract::wrap(a_raw);
+        typename Contract::pointer b_arr = Contract::wrap(b_raw);
+        typename Contract::pointer c_arr = Contract::wrap(c_raw);
+        size_t roots_count = 0u;
+        const size_t lb = Bound::get();
+        #pragma omp parallel for schedule(static) reduction(+:roots_count)
+        for (size_t i = 0; i < lb; ++i) {
+            roots_count += quadratic_roots(a_arr[i], b_arr[i], c_arr[i]);
         }
+        return roots_count;
+    }
+};
 
+// Собственный пул потоков: статическое разбиение на равные куски, кусок k - потоку k пула,
+// как у schedule(static) в OMP и first_touch_parallel (при равном числе потоков).
+// Указатели захватываются лямбдой, поэтому __restrict__ здесь компилятору не виден.
+struct POOL {
+    static constexpr const char *name = "POOL";
+    static constexpr bool openmp = false;
+    static unsigned threads() { return kernel_pool().size(); }
+    template <typename Contract, typename Bound>
+    static size_t run(double *a_raw, double *b_raw, double *c_raw)
+    {
+        ThreadPool &pool = kernel_pool();
+        typename Contract::pointer a_arr = Contract::wrap(a_raw);
+        typename Contract::pointer b_arr = Contract::wrap(b_raw);
+        typename Contract::pointer c_arr = Contract::wrap(c_raw);
+        const size_t lb = Bound::get();
+        const size_t chunks = pool.size();
+        vector<size_t> partial(chunks, 0);
+        pool.run_on_each_thread([&](unsigned k) {
+            size_t begin = lb * k / chunks, end = lb * (k + 1) / chunks;
+            size_t roots_count = 0u;
+            for (size_t i = begin; i < end; ++i) {
+                roots_count += quadratic_roots(a_arr[i], b_arr[i], c_arr[i]);
+            }
+            partial[k] = roots_count;
+        });
         size_t roots_count = 0u;
-        auto t_start = clk::now();
+        for (size_t r : partial) roots_count += r;
+        return roots_count;
+    }
+};
 
-        if (with_openmp)
-        {
-            #ifdef _OPENMP
-              int max_thr = omp_get_max_threads();
-            #else
-              int max_thr = 1;
-            #endif
-
-            if (mode == BASE) {
-                size_t lb = (use_const_bound ? loop_bound_c : loop_bound_var);
-                #pragma omp parallel for reduction(+:roots_count)
-                for (size_t i = 0; i < lb; ++i) {
-                    double a = a_arr[i];
-                    double b = b_arr[i];
-                    double c = c_arr[i];
-                    double D = b*b - 4.0*a*c;
-                    if (D >= 0.0) {
-                        double sd = sqrt(D);
-                        double x1 = (-b + sd)/(2.0*a);
-                        double x2 = (-b - sd)/(2.0*a);
-                        (void)x1; (void)x2;
-                        roots_count += 2;
-                    }
-                }
-            }
-            else if (mode == CONST_ALL) {
-                size_t lb = (use_const_bound ? loop_bound_c : loop_bound_var);
-                #pragma omp parallel for reduction(+:roots_count)
-                for (size_t i = 0; i < lb; ++i) {
-                    double a = a_arr_c[i];
-                    double b = b_arr_c[i];
-                    double c = c_arr_c[i];
-                    double D = b*b - 4.0*a*c;
-                    if (D >= 0.0) {
-                        double sd = sqrt(D);
-                        double x1 = (-b + sd)/(2.0*a);
-                        double x2 = (-b - sd)/(2.0*a);
-                        (void)x1; (void)x2;
-                        roots_count += 2;
-                    }
-                }
-            }
-            else if (mode == VOLATILE_ALL) {
-                size_t lb = (use_const_bound ? loop_bound_c : loop_bound_var);
-                #pragma omp parallel for reduction(+:roots_count)
-                for (size_t i = 0; i < lb; ++i) {
-                    double a = a_arr_v[i];
-                    double b = b_arr_v[i];
-                    double c = c_arr_v[i];
-                    double D = b*b - 4.0*a*c;
-                    if (D >= 0.0) {
-                        double sd = sqrt(D);
-                        double x1 = (-b + sd)/(2.0*a);
-                        double x2 = (-b - sd)/(2.0*a);
-                        (void)x1; (void)x2;
-                        roots_count += 2;
-                    }
-                }
-            }
-            else if (mode == RESTRICT_ALL) {
-                size_t lb = (use_const_bound ? loop_bound_c : loop_bound_var);
-                #pragma omp parallel for reduction(+:roots_count)
-                for (size_t i = 0; i < lb; ++i) {
-                    double a = a_arr_r[i];
-                    double b = b_arr_r[i];
-                    double c = c_arr_r[i];
-                    double D = b*b - 4.0*a*c;
-                    if (D >= 0.0) {
-                        double sd = sqrt(D);
-                        double x1 = (-b + sd)/(2.0*a);
-                        double x2 = (-b - sd)/(2.0*a);
-                        (void)x1; (void)x2;
-                        roots_count += 2;
-                    }
-                }
-            }
+#ifdef USE_PSTL
+// std::execution::par_unseq; с libstdc++ требует -ltbb
+struct PSTL {
+    static constexpr const char *name = "PSTL";
+    static constexpr bool openmp = false;
+    static unsigned threads() { return max(1u, thread::hardware_concurrency()); }
+    template <typename Contract, typename Bound>
+    static size_t run(double *a_raw, double *b_raw, double *c_raw)
+    {
+        typename Contract::pointer a_arr = Contract::wrap(a_raw);
+        typename Contract::pointer b_arr = Contract::wrap(b_raw);
+        typename Contract::pointer c_arr = Contract::wrap(c_raw);
+        const size_t lb = Bound::get();
+        return transform_reduce(execution::par_unseq, a_arr, a_arr + lb, size_t(0), plus<>(),
+                                [=](auto &a) { size_t i = &a - a_arr; return quadratic_roots(a, b_arr[i], c_arr[i]); });
+    }
+};
+#endif
+
+template <typename... Ts> struct TypeList {};
+
+// Склейка списков типов: только для decltype, поэтому без определения
+template <typename... As, typename... Bs>
+TypeList<As..., Bs...> operator+(TypeList<As...>, TypeList<Bs...>);
+
+#define CONTRACT_TYPE(NAME, POINTER, WRAP) + TypeList<NAME>{}
+using Contracts = decltype(TypeList<>{} QUADRATIC_CONTRACTS(CONTRACT_TYPE));
+#undef CONTRACT_TYPE
+using Bounds = TypeList<VarBound, ConstBound>;
+#ifdef USE_PSTL
+using Policies = TypeList<NOOMP, OMP, POOL, PSTL>;
+#else
+using Policies = TypeList<NOOMP, OMP, POOL>;
+#endif
+
+struct QuadraticVariant {
+    string name;         // <контракт>_<политика>, как в выводе прежней версии
+    const char *bound;
+    bool openmp;
+    unsigned (*threads)();
+    size_t (*run)(double *, double *, double *);
+};
+
+template <typename Contract, typename Bound, typename Policy>
+void register_variant(vector<QuadraticVariant> &registry)
+{
+    registry.push_back({string(Contract::name) + "_" + Policy::name, Bound::name, Policy::openmp,
+                        &Policy::threads, &Policy::template run<Contract, Bound>});
+}
+
+// Все сочетания в порядке: контракт -> граница -> политика
+template <typename Contract, typename Bound, typename... Ps>
+void register_policies(vector<QuadraticVariant> &registry, TypeList<Ps...>)
+{
+    (register_variant<Contract, Bound, Ps>(registry), ...);
+}
+
+template <typename Contract, typename... Bs>
+void register_bounds(vector<QuadraticVariant> &registry, TypeList<Bs...>)
+{
+    (register_policies<Contract, Bs>(registry, Policies{}), ...);
+}
+
+template <typename... Cs>
+vector<QuadraticVariant> make_registry(TypeList<Cs...>)
+{
+    vector<QuadraticVariant> registry;
+    (register_bounds<Cs>(registry, Bounds{}), ...);
+    return registry;
+}
+
+// Настройки размещения памяти и привязки потоков (аргументы командной строки)
+struct PlacementOptions {
+    bool first_touch = false;                      // --init=first-touch
+    ThreadBinding binding = ThreadBinding::NONE;   // --bind=compact|scatter
+};
+
+using NumaVector = vector<double, FirstTouchAllocator<double>>;
+
+// Параллельное первое касание с тем же статическим расписанием, что у OMP-варианта ядра:
+// каждая страница оказывается на узле потока, который потом будет ее читать
+void first_touch_parallel(NumaVector &v)
+{
+    double *p = v.data();
+    const size_t n = v.size();
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = 0.0;
+    }
+}
+
+// Привязывает потоки OpenMP к CPU в порядке compact/scatter; потоки пула OpenMP
+// переиспользуются между параллельными областями, поэтому привязка сохраняется
+void bind_openmp_threads(const NumaTopology &topo, ThreadBinding binding)
+{
+    if (binding == ThreadBinding::NONE) return;
+    vector<int> order = binding_order(topo, binding);
+    #pragma omp parallel
+    {
+      #ifdef _OPENMP
+        int t = omp_get_thread_num();
+      #else
+        int t = 0;
+      #endif
+        pin_current_thread(order[t % order.size()]);
+    }
+}
+
+// То же для потоков kernel_pool: поток k пула - на тот же CPU, что поток k OpenMP
+void bind_pool_threads(const NumaTopology &topo, ThreadBinding binding)
+{
+    if (binding == ThreadBinding::NONE) return;
+    vector<int> order = binding_order(topo, binding);
+    kernel_pool().run_on_each_thread([&](unsigned k) { pin_current_thread(order[k % order.size()]); });
+}
+
+// Размещение страниц по узлам и пропускная способность чтения A, B, C по узлам:
+// каждый поток читает свой статический кусок, байты узла делятся на время его самого медленного потока
+void report_numa_placement(const NumaTopology &topo, const NumaVector &A, const NumaVector &B, const NumaVector &C)
+{
+    const int nodes = topo.nodes();
+    vector<size_t> pages = pages_per_node(A.data(), A.size() * sizeof(double), nodes);
+    cout << "Страницы массива A по узлам:";
+    for (int node = 0; node < nodes; ++node) cout << " node" << node << "=" << pages[node];
+    cout << " unknown=" << pages[nodes] << "\n";
+
+    struct ThreadStat { int node; size_t bytes; double seconds; };
+  #ifdef _OPENMP
+    vector<ThreadStat> stats(omp_get_max_threads(), {-1, 0, 0.0});
+  #else
+    vector<ThreadStat> stats(1, {-1, 0, 0.0});
+  #endif
+    double checksum = 0.0;
+    #pragma omp parallel reduction(+:checksum)
+    {
+      #ifdef _OPENMP
+        int t = omp_get_thread_num();
+      #else
+        int t = 0;
+      #endif
+        size_t count = 0;
+        double local = 0.0;
+        auto t0 = clk::now();
+        #pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < A.size(); ++i) {
+            local += A[i] + B[i] + C[i];
+            ++count;
         }
-        else
-        {
-            if (mode == BASE) {
-                size_t lb = (use_const_bound ? loop_bound_c : loop_bound_var);
-                for (size_t i = 0; i < lb; ++i) {
-                    double a = a_arr[i];
-                    double b = b_arr[i];
-                    double c = c_arr[i];
-                    double D = b*b - 4.0*a*c;
-                    if (D >= 0.0) {
-                        double sd = sqrt(D);
-                        double x1 = (-b + sd)/(2.0*a);
-                        double x2 = (-b - sd)/(2.0*a);
-                        (void)x1; (void)x2;
-                        roots_count += 2;
-                    }
-                }
-            }
-            else if (mode == CONST_ALL) {
-                size_t lb = (use_const_bound ? loop_bound_c : loop_bound_var);
-                for (size_t i = 0; i < lb; ++i) {
-                    double a = a_arr_c[i];
-                    double b = b_arr_c[i];
-                    double c = c_arr_c[i];
-                    double D = b*b - 4.0*a*c;
-                    if (D >= 0.0) {
-                        double sd = sqrt(D);
-                        double x1 = (-b + sd)/(2.0*a);
-                        double x2 = (-b - sd)/(2.0*a);
-                        (void)x1; (void)x2;
-                        roots_count += 2;
-                    }
-                }
-            }
-            else if (mode == VOLATILE_ALL) {
-                size_t lb = (use_const_bound ? loop_bound_c : loop_bound_var);
-                for (size_t i = 0; i < lb; ++i) {
-                    double a = a_arr_v[i];
-                    double b = b_arr_v[i];
-                    double c = c_arr_v[i];
-                    double D = b*b - 4.0*a*c;
-                    if (D >= 0.0) {
-                        double sd = sqrt(D);
-                        double x1 = (-b + sd)/(2.0*a);
-                        double x2 = (-b - sd)/(2.0*a);
-                        (void)x1; (void)x2;
-                        roots_count += 2;
-                    }
-                }
-            }
-            else if (mode == RESTRICT_ALL) {
-                size_t lb = (use_const_bound ? loop_bound_c : loop_bound_var);
-                for (size_t i = 0; i < lb; ++i) {
-                    double a = a_arr_r[i];
-                    double b = b_arr_r[i];
-                    double c = c_arr_r[i];
-                    double D = b*b - 4.0*a*c;
-                    if (D >= 0.0) {
-                        double sd = sqrt(D);
-                        double x1 = (-b + sd)/(2.0*a);
-                        double x2 = (-b - sd)/(2.0*a);
-                        (void)x1; (void)x2;
-                        roots_count += 2;
-                    }
-                }
-            }
+        auto t1 = clk::now();
+        checksum += local;
+        stats[t] = {topo.node_of_cpu(current_cpu()), count * 3 * sizeof(double),
+                    chrono::duration<double>(t1 - t0).count()};
+    }
+
+    for (int node = 0; node < nodes; ++node) {
+        size_t bytes = 0, threads = 0;
+        double slowest = 0.0;
+        for (const auto &s : stats) {
+            if (s.node != node) continue;
+            bytes += s.bytes;
+            slowest = max(slowest, s.seconds);
+            ++threads;
         }
+        if (threads == 0) continue;
+        cout << "Node " << node << ": threads=" << threads
+             << " | Bandwidth=" << bytes / slowest / 1e9 << " GB/s\n";
+    }
+    cout << "(checksum " << checksum << ")\n\n";
+}
+
+void fill_coefficients(NumaVector &A, NumaVector &B, NumaVector &C)
+{
+    mt19937_64 rng(42);
+    uniform_real_distribution<double> dist(-1000.0, 1000.0);
+    for (size_t i = 0; i < A.size(); ++i) {
+        double a = dist(rng);
+        while (fabs(a) < 1e-9) {
+            a = dist(rng);
+        }
+        A[i] = a;
+        B[i] = dist(rng);
+        C[i] = dist(rng);
+    }
+}
+
+void experiment_quadratic(const PlacementOptions &opts)
+{
+    cout << "=== Часть A: решение квадратных уравнений ===\n\n";
 
+    NumaTopology topo = NumaTopology::detect();
+    bind_openmp_threads(topo, opts.binding);
+    bind_pool_threads(topo, opts.binding);
+
+    NumaVector A(N), B(N), C(N);
+    if (opts.first_touch) {
+        first_touch_parallel(A);
+        first_touch_parallel(B);
+        first_touch_parallel(C);
+    }
+    fill_coefficients(A, B, C);
+
+    cout << "Init=" << (opts.first_touch ? "first-touch" : "serial")
+         << " | Bind=" << (opts.binding == ThreadBinding::COMPACT ? "compact"
+                          : opts.binding == ThreadBinding::SCATTER ? "scatter" : "none")
+         << " | NUMA nodes=" << topo.nodes() << "\n";
+    report_numa_placement(topo, A, B, C);
+
+    for (const auto &v : make_registry(Contracts{})) {
+        PerfScope perf_scope("lab9/" + string(v.name) + "/" + v.bound);
+        perf_scope.set_threads(v.threads());
+        auto t_start = clk::now();
+        size_t roots_count = v.run(A.data(), B.data(), C.data());
         auto t_end = clk::now();
+        perf_scope.stop();
         double elapsed = chrono::duration<double>(t_end - t_start).count();
 
-        cout << "Variant: " << name
-             << " | bound=" << (use_const_bound ? "const" : "var")
-             << " | OpenMP=" << (with_openmp ? "ON" : "OFF")
+        cout << "Variant: " << v.name
+             << " | bound=" << v.bound
+             << " | OpenMP=" << (v.openmp ? "ON" : "OFF")
              << " | Time=" << elapsed << " s"
              << " | Roots=" << roots_count
              << "\n";
-    };
-
-    vector<string> contracts = { "BASELINE", "CONST_ALL", "VOLATILE_ALL", "RESTRICT_ALL" };
-    for (const auto &ct : contracts) {
-        for (bool use_c : { false, true }) {     // false = var-bound, true = const-bound
-            for (bool omp_on : { false, true }) { // false = без OpenMP, true = с OpenMP
-                string name = ct + (omp_on ? "_OMP" : "_NOOMP");
-                run_variant(name,
-                            A.data(),
-                            B.data(),
-                            C.data(),
-                            use_c,
-                            omp_on);
-            }
-        }
     }
 }
 
@@ -279,18 +404,18 @@ void experiment_useless_sum()
     cout << "\n=== Часть B: бесполезная сумма (volatile vs non-volatile) ===\n\n";
 
     static constexpr size_t M = 200'000'000;
-    double *arr = new double[M];
-    for (size_t i = 0; i < M; ++i) {
-        arr[i] = 1.0;
-    }
+    vector<double> data(M, 1.0);
+    const double *arr = data.data();
 
     {
         double sum = 0.0;
+        PerfScope perf_scope("lab9/sum/non-volatile");
         auto t0 = clk::now();
         for (size_t i = 0; i < M; ++i) {
             sum += arr[i];
         }
         auto t1 = clk::now();
+        perf_scope.stop();
         double t = chrono::duration<double>(t1 - t0).count();
         cout << "Sum (non-volatile):\t time = " << t << " s"
              << " | sum_snapshot = " << sum << "\n";
@@ -298,28 +423,98 @@ void experiment_useless_sum()
 
     {
         volatile double sum2 = 0.0;
+        PerfScope perf_scope("lab9/sum/volatile");
         auto t0 = clk::now();
         for (size_t i = 0; i < M; ++i) {
-            sum2 += arr[i];
+            sum2 = sum2 + arr[i];
         }
         auto t1 = clk::now();
+        perf_scope.stop();
         double t = chrono::duration<double>(t1 - t0).count();
         cout << "Sum (volatile):\t time = " << t << " s"
              << " | sum_snapshot = " << sum2 << "\n";
     }
 
-    delete [] arr;
+    // Модуль свертки: несколько аккумуляторов + SIMD, компенсированный режим и
+    // параллельное дерево по блокам, результат которого не зависит от числа потоков
+    auto measure = [&](const char *label, unsigned threads, auto &&reduce) {
+        PerfScope perf_scope(string("lab9/") + label);
+        perf_scope.set_threads(threads);
+        auto t0 = clk::now();
+        double s = reduce();
+        auto t1 = clk::now();
+        perf_scope.stop();
+        double t = chrono::duration<double>(t1 - t0).count();
+        cout << label << "\t time = " << t << " s"
+             << " | sum_snapshot = " << setprecision(17) << s << setprecision(6) << "\n";
+    };
+    measure("Sum (multi-acc SIMD):", 1, [&] { return sum_array(arr, M); });
+    measure("Sum (Neumaier SIMD):", 1, [&] { return sum_array(arr, M, SumMode::COMPENSATED); });
+
+    ThreadPool single(1);
+    ThreadPool &pool = kernel_pool();
+    measure("Sum (tree, 1 thread):", 1, [&] { return parallel_sum(single, arr, M); });
+    string label = "Sum (tree, " + to_string(pool.size()) + " threads):";
+    measure(label.c_str(), pool.size(), [&] { return parallel_sum(pool, arr, M); });
+    label = "Sum (tree Neumaier, " + to_string(pool.size()) + " threads):";
+    measure(label.c_str(), pool.size(), [&] { return parallel_sum(pool, arr, M, SumMode::COMPENSATED); });
 }
 
 
-int main()
+// Режим bench: все варианты реестра и суммы через общий микробенчмарк (common/bench.h)
+int run_bench(int argc, char *argv[])
 {
+    NumaVector A(N), B(N), C(N);
+    fill_coefficients(A, B, C);
+    vector<double> ones(N, 1.0);
+    ThreadPool &pool = kernel_pool();
+
+    BenchRegistry registry;
+    for (const auto &v : make_registry(Contracts{})) {
+        auto run = v.run;
+        registry.add("lab9/" + string(v.name) + "/" + v.bound,
+                     [&, run] { do_not_optimize(run(A.data(), B.data(), C.data())); },
+                     v.threads());
+    }
+    registry.add("lab9/sum/multi-acc", [&] { do_not_optimize(sum_array(ones.data(), N)); });
+    registry.add("lab9/sum/neumaier", [&] { do_not_optimize(sum_array(ones.data(), N, SumMode::COMPENSATED)); });
+    registry.add("lab9/sum/tree/threads=" + to_string(pool.size()),
+                 [&] { do_not_optimize(parallel_sum(pool, ones.data(), N)); }, pool.size());
+    return registry.main(argc, argv);
+}
+
+
+// Запуск: main.exe [--init=serial|first-touch] [--bind=none|compact|scatter]
+//         main.exe bench [опции bench.h]
+int main(int argc, char *argv[])
+{
+#ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
     SetConsoleCP(CP_UTF8);
+#endif
+
+    if (argc > 1 && string(argv[1]) == "bench") {
+        return run_bench(argc, argv);
+    }
+
+    PlacementOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if      (arg == "--init=first-touch") opts.first_touch = true;
+        else if (arg == "--init=serial")      opts.first_touch = false;
+        else if (arg == "--bind=compact")     opts.binding = ThreadBinding::COMPACT;
+        else if (arg == "--bind=scatter")     opts.binding = ThreadBinding::SCATTER;
+        else if (arg == "--bind=none")        opts.binding = ThreadBinding::NONE;
+        else {
+            cerr << "Неизвестный аргумент: " << arg << "\n";
+            return 1;
+        }
+    }
+
     std::cout << "\nЛабораторная №9: контракты с компилятором (с OpenMP)\n";
     std::cout << "====================================================\n\n";
 
-    experiment_quadratic();
+    experiment_quadratic(opts);
 
     experiment_useless_sum();
 